@@ -0,0 +1,37 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "solvers.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+// the kernels of the matrix-vector products, each of them built with its default parameters
+extern const std::vector<std::string> kernels;
+
+// the file caching the fastest kernel of each graph on each host for a maximum number of threads and a type of the
+// ranks, one "host fingerprint max_threads value_bits kernel threads" per line, where value_bits is the width of
+// pprank_t and the kernel of the specialized ones is the name of the fastest of them (e.g. "u32-float-column")
+const char* const tuning_file = "pprank-tuning.txt";
+
+tdot_fn build_kernel(const TCSR&, const std::string&, uint_fast32_t);
+
+std::vector<std::tuple<std::string, uint_fast32_t, double>> autotune(const TCSR&, uint_fast32_t,
+    uint_fast32_t = 3);
+
+std::string graph_fingerprint(const TCSR&);
+std::string host_name();
+
+std::tuple<std::string, uint_fast32_t> load_tuning(const std::string&, const std::string&, const std::string&,
+    uint_fast32_t);
+void save_tuning(const std::string&, const std::string&, const std::string&, uint_fast32_t, const std::string&,
+    uint_fast32_t);
+
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BINNED_HPP
+#define BINNED_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct RowBin {
+    // a group of rows of the transposed matrix, whose nonzero values are stored contiguously in the order of the rows
+    // note that the column indices fit 32 bits, halving their memory traffic
+    std::vector<uint_fast32_t> rows, ia;
+    std::vector<uint32_t> ja;
+    std::vector<pprank_t> a;
+};
+
+struct BinnedTCSR {
+    // pull layout: the matrix is stored transposed, and its rows are grouped by degree when the matrix is built, so
+    // that each group is computed by a kernel suited to it:
+    // - the tiny rows (at most tiny_degree nonzero values) are grouped by exact degree, each group by a fully
+    //   unrolled kernel (without the offsets of the rows, since they all have the same length)
+    // - the medium rows by a vectorized dot product
+    // - the huge rows (more than huge_threshold nonzero values) are split into segments of segment_size nonzero
+    //   values, computed in parallel and then summed: segment s starts at the nonzero value segment_starts[s] of
+    //   the huge bin, within its row segment_rows[s]
+    static constexpr uint_fast32_t tiny_degree = 8;
+    static constexpr uint_fast32_t segment_size = 4096;
+
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t huge_threshold;
+    std::vector<RowBin> tiny_bins;
+    RowBin medium_bin, huge_bin;
+    std::vector<uint_fast32_t> segment_rows, segment_starts;
+    mutable std::vector<pprank_t> segment_sums;
+
+    // the time spent on each bin (tiny, medium and huge), summed over all the products since the last call to
+    // reset_stats()
+    mutable std::vector<double> bin_time;
+
+    BinnedTCSR(const TCSR&, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+
+    void reset_stats() const;
+};
+
+extern const std::vector<std::string> bin_names;
+
+
+#endif
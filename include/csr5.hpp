@@ -0,0 +1,47 @@
+#ifndef CSR5_HPP
+#define CSR5_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct Csr5TCSR {
+    // CSR5 (Liu and Vinter, 2015): the nonzero values of the transposed matrix are split into tiles of omega x sigma
+    // values, so that every tile is the same amount of work however long the rows are; within a tile, lane l (one
+    // per SIMD lane) owns the sigma consecutive values starting at l*sigma, and the tile is stored transposed, i.e.
+    // step s of all the lanes is stored contiguously at s*omega, so that each step is a single SIMD load
+    // each tile is described by:
+    // - tile_ptr[t], the row of its first nonzero value
+    // - bit_flag[t], whose bit s*omega+l is set if the value of lane l at step s is the first of a row
+    // - y_offset[t*omega+l], the number of rows starting in the lanes before l, i.e. the row (relative to the
+    //   first one starting in the tile) of the first row starting in lane l
+    // - for the tiles spanning empty rows, the rows starting in them, in empty_offset[empty_ptr[t]:empty_ptr[t+1]]
+    //   (the other tiles number their rows consecutively from tile_ptr[t])
+    // the last tile is padded with zeros, and the sum of the row continuing from the previous tiles is carried and
+    // added at the end
+    static constexpr uint_fast32_t omega = 32/sizeof(pprank_t);  // the values fitting a 256-bit register
+    static constexpr uint_fast32_t sigma = 64/omega;             // so that the bit flags of a tile fit 64 bits
+    static constexpr uint_fast32_t tile_size = omega*sigma;
+
+    uint_fast32_t num_rows, num_cols;
+    std::vector<pprank_t> a;
+    std::vector<uint32_t> ja;
+    std::vector<uint_fast32_t> tile_ptr;
+    std::vector<uint64_t> bit_flag;
+    std::vector<uint8_t> y_offset;
+    std::vector<uint_fast32_t> empty_ptr, empty_offset;
+    std::vector<uint_fast32_t> empty_rows;
+    mutable std::vector<pprank_t> carry;
+
+    Csr5TCSR(const TCSR&);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HYBRID_HPP
+#define HYBRID_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct HybridTCSR {
+    // the rows with more than hub_threshold nonzero values (the hubs) are removed from the CSR matrix and stored
+    // separately, grouped in chunks of chunk_size columns: chunk c contains, for each hub h, its nonzero values in
+    // the columns [c*chunk_size, (c+1)*chunk_size), located by hub_ia[c*hubs.size()+h]
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t hub_threshold, chunk_size;
+    TCSR regular;
+    std::vector<uint_fast32_t> hubs;
+    std::vector<pprank_t> hub_a;
+    std::vector<uint_fast32_t> hub_ia, hub_ja;
+
+    HybridTCSR(const TCSR&, uint_fast32_t = 0, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+uint_fast32_t default_hub_threshold(const TCSR&);
+
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef MERGEPATH_HPP
+#define MERGEPATH_HPP
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct MergePathTCSR {
+    // merge-path SpMV: the rows of the transposed matrix and its nonzero values are seen as a single sequence, which
+    // is split evenly among the threads regardless of how the nonzero values are distributed among the rows
+    // a thread whose part ends in the middle of a row carries its partial sum, which is added to the result after
+    // all the threads have finished
+    TCSR at;
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t num_threads;
+    std::vector<uint_fast32_t> row_starts, nz_starts;
+    mutable std::vector<uint_fast32_t> carry_rows;
+    mutable std::vector<pprank_t> carry_values;
+
+    MergePathTCSR(const TCSR&, uint_fast32_t);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+std::tuple<uint_fast32_t, uint_fast32_t> merge_path_search(const TCSR&, uint_fast64_t);
+
+
+#endif
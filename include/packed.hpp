@@ -0,0 +1,31 @@
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct PackedTCSR {
+    // the column indices are stored in a stream of bits, each one using the minimum number of bits needed to
+    // represent num_cols-1; the stream is padded so that 8 bytes can always be read from the byte of any index
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t bits;
+    std::vector<pprank_t> a;
+    std::vector<uint_fast32_t> ia;
+    std::vector<uint64_t> packed_ja;
+    void (*kernel)(const PackedTCSR&, const pprank_t*, pprank_t*);
+
+    PackedTCSR(const TCSR&);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+
+    uint_fast32_t col(uint_fast32_t) const;
+};
+
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+template<typename V, typename R = V>
+struct BasicThreadedTCSR {
+    // each thread owns a block of rows with about the same number of nonzero values, and scatters their
+    // contributions into its own copy of the result; the copies are then summed by all the threads together
+    // the nonzero values have type V, while the vectors (and thus the sums) have type R
+    // note that the matrix is not copied, so it must outlive this object
+    const BasicTCSR<V>& tcsr;
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t num_threads;
+    std::vector<uint_fast32_t> bounds;
+    mutable std::vector<arma::Col<R>> buffers;
+
+    BasicThreadedTCSR(const BasicTCSR<V>&, uint_fast32_t);
+
+    arma::Col<R> tdot(const arma::Col<R>&) const;
+    void tdot(const arma::Col<R>&, arma::Col<R>&) const;
+};
+
+using ThreadedTCSR = BasicThreadedTCSR<pprank_t>;
+
+uint_fast32_t max_threads();
+template<typename V> std::vector<uint_fast32_t> balanced_bounds(const BasicTCSR<V>&, uint_fast32_t);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct PrefetchTCSR {
+    // while processing the k-th nonzero value, the entry of the result written by the (k+distance)-th one is
+    // prefetched, since the hardware prefetcher cannot predict these data-dependent accesses
+    // note that the matrix is not copied, so it must outlive this object
+    const TCSR& tcsr;
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t distance;
+
+    PrefetchTCSR(const TCSR&, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+extern const std::vector<uint_fast32_t> prefetch_distances;
+
+uint_fast32_t calibrate_distance(const TCSR&);
+
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PROPAGATION_HPP
+#define PROPAGATION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct PropagationTCSR {
+    // propagation blocking: the contributions of all the rows are first appended to bins, each one covering a range
+    // of 2^bin_bits columns, and then the bins are accumulated into the result one at a time
+    // since the matrix does not change, the destination of each entry of a bin is computed only once
+    // note that the matrix is not copied, so it must outlive this object
+    const TCSR& tcsr;
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t bin_bits;
+    std::vector<uint_fast32_t> bin_ia, bin_ja;
+    mutable std::vector<pprank_t> bin_values;
+    mutable std::vector<uint_fast32_t> bin_next;
+
+    PropagationTCSR(const TCSR&, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+// a node ordering is a permutation perm, where perm[i] is the new id of node i
+extern const std::vector<std::string> reorder_strategies;
+
+std::vector<uint_fast32_t> degree_order(const TCSR&);
+std::vector<uint_fast32_t> hub_order(const TCSR&);
+std::vector<uint_fast32_t> rcm_order(const TCSR&);
+std::vector<uint_fast32_t> gorder_order(const TCSR&, uint_fast32_t = 5);
+
+std::vector<uint_fast32_t> reorder(const TCSR&, const std::string&);
+
+template<typename T> arma::Col<T> unpermute(const arma::Col<T>&, const std::vector<uint_fast32_t>&);
+
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SEGMENTED_HPP
+#define SEGMENTED_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct SegmentedTCSR {
+    // the columns of the matrix are split into ranges of segment_size columns, and the nonzero values of each
+    // range are stored in a separate segment; only the non-empty rows of a segment are stored
+    struct Segment {
+        std::vector<pprank_t> a;
+        std::vector<uint_fast32_t> rows, ia, ja;
+    };
+
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t segment_size;
+    std::vector<Segment> segments;
+
+    SegmentedTCSR(const TCSR&, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+uint_fast32_t default_segment_size();
+
+
+#endif
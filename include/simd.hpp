@@ -0,0 +1,36 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct SimdTCSR {
+    // pull layout: the matrix is stored transposed, so that each entry of the result is a dot product between a row
+    // and the input vector, computed with gathers and without conflicting writes
+    // the kernel is chosen at runtime among the instruction sets supported by the processor
+    uint_fast32_t num_rows, num_cols;
+    std::string isa;
+    std::vector<pprank_t> a;
+    std::vector<uint_fast32_t> ia;
+    std::vector<uint32_t> ja;
+    void (*kernel)(const SimdTCSR&, const pprank_t*, const pprank_t*, pprank_t*);
+
+    SimdTCSR(const TCSR&, const std::string& = "");
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+extern const std::vector<std::string> simd_isas;
+
+std::string detect_isa();
+bool supports_isa(const std::string&);
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SOLVERS_HPP
+#define SOLVERS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+// a matrix-vector product with the matrix transposed, into a vector allocated by the caller
+template<typename R> using basic_tdot_fn = std::function<void(const arma::Col<R>&, arma::Col<R>&)>;
+using tdot_fn = basic_tdot_fn<pprank_t>;
+
+template<typename R>
+struct QuadraticExtrapolation {
+    // quadratic extrapolation (Kamvar et al., 2003): every period iterations, the last iterate of the power iteration
+    // is replaced by the combination of the last three which cancels the two largest terms of its error, assuming
+    // that the error of the last four iterates lies in the span of two eigenvectors
+    // the iterates are copied only in the three iterations before each extrapolation, so that the other ones are
+    // not slowed down; a period of zero disables it
+    uint_fast32_t period;
+    std::vector<arma::Col<R>> history;
+    uint_fast32_t extrapolations = 0;
+
+    QuadraticExtrapolation(uint_fast32_t, uint_fast32_t);
+
+    bool step(uint_fast32_t, arma::Col<R>&);
+};
+
+template<typename V, typename R>
+std::tuple<uint_fast32_t, arma::Col<R>> pagerank_power(const BasicTCSR<V>&, const basic_tdot_fn<R>&, const double,
+        const arma::Col<R>& = arma::Col<R>(), const uint_fast32_t = 0);
+template<typename V, typename R>
+std::tuple<uint_fast32_t, bool, arma::Col<R>> pagerank_gmres(const BasicTCSR<V>&, const basic_tdot_fn<R>&,
+        const double, const uint_fast32_t = 10, const arma::Col<R>& = arma::Col<R>());
+template<typename V, typename R>
+std::tuple<uint_fast32_t, bool, arma::Col<R>> pagerank_bicgstab(const BasicTCSR<V>&, const basic_tdot_fn<R>&,
+        const double, const arma::Col<R>& = arma::Col<R>());
+std::tuple<uint_fast32_t, pprank_vec_t> pagerank_fused(const TCSR&, const pprank_t);
+std::tuple<uint_fast32_t, pprank_vec_t> pagerank_gauss_seidel(const TCSR&, const pprank_t, const uint_fast32_t = 1);
+std::tuple<std::vector<uint_fast32_t>, pprank_mat_t> pagerank_batched(const TCSR&, const pprank_mat_t&,
+        const pprank_t);
+std::tuple<uint_fast32_t, uint_fast32_t, uint_fast64_t, pprank_vec_t> pagerank_push_pull(const TCSR&, const pprank_t,
+        const pprank_t = 0);
+std::tuple<uint_fast32_t, uint_fast64_t, pprank_vec_t> pagerank_adaptive(const TCSR&, const pprank_t,
+        const pprank_t = 0, const uint_fast32_t = 8);
+
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SPECIALIZED_HPP
+#define SPECIALIZED_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "solvers.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+// the layouts of the specialized kernels: push along the rows of the matrix (like TCSR::tdot), or pull along the
+// rows of the transposed matrix (like SimdTCSR)
+enum class Layout { row, column };
+
+template<typename I, typename V, Layout L>
+struct SpecializedTCSR {
+    // a copy of the matrix (transposed for the column layout) with indices of type I and nonzero values of type V,
+    // whose product is compiled separately for each combination, so that the widths of the loads and the unrolling
+    // of the inner loop are known at compile time
+    // note that the products still accumulate into ranks of type pprank_t
+    static constexpr uint_fast32_t unroll = 32/sizeof(V);  // the values fitting a 256-bit register
+
+    uint_fast32_t num_rows, num_cols;
+    std::vector<V> a;
+    std::vector<I> ia, ja;
+
+    SpecializedTCSR(const TCSR&);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+};
+
+struct Specialization {
+    // an entry of the table of the specialized kernels, named after its index width, value type and layout
+    // (e.g. "u32-float-column")
+    std::string name;
+    uint_fast32_t index_bits, value_bits;
+    std::function<tdot_fn(const TCSR&)> build;
+};
+
+extern const std::vector<Specialization> specializations;
+
+bool fits(const Specialization&, const TCSR&);
+std::vector<double> calibrate_specializations(const TCSR&, uint_fast32_t = 3);
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef STEALING_HPP
+#define STEALING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct ChunkDeque {
+    // a lock-free work-stealing deque (Chase-Lev) of chunk ids: the owner pops from the bottom, while the other
+    // threads steal from the top; since no chunk is added during a product, the ids are stored in a fixed array and
+    // the deque is simply refilled before each product
+    std::vector<uint_fast32_t> chunks;
+    std::atomic<int_fast64_t> top, bottom;
+
+    ChunkDeque();
+
+    void reset();
+    bool pop(uint_fast32_t&);
+    bool steal(uint_fast32_t&);
+};
+
+struct StealingTCSR {
+    // the rows of the transposed matrix are split in many small chunks with about the same number of nonzero values,
+    // and each thread starts with a contiguous range of them in its own deque; when its deque is empty, a thread
+    // steals the chunks left in the deques of the others, so that no thread stays idle while there is work left
+    // since each row of the transposed matrix is an entry of the result, the threads never write the same entries
+    TCSR at;
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t num_threads;
+    std::vector<uint_fast32_t> bounds;
+    mutable std::vector<ChunkDeque> deques;
+
+    // the time each thread spent computing chunks (busy) and looking for them or waiting for the others (idle),
+    // and the number of chunks it stole, summed over all the products since the last call to reset_stats()
+    mutable std::vector<double> busy_time, idle_time;
+    mutable std::vector<uint_fast64_t> stolen;
+
+    StealingTCSR(const TCSR&, uint_fast32_t, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+
+    void reset_stats() const;
+};
+
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TILED_HPP
+#define TILED_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+struct TiledTCSR {
+    // the matrix is split into square tiles of at most 65536x65536 values, so that the row and column indices
+    // inside a tile fit in 16 bits; only the non-empty rows of the non-empty tiles are stored
+    struct Tile {
+        uint_fast32_t row_base, col_base;
+        uint_fast32_t first_row, last_row;
+    };
+
+    uint_fast32_t num_rows, num_cols;
+    uint_fast32_t tile_size;
+    std::vector<Tile> tiles;
+    std::vector<pprank_t> a;
+    std::vector<uint16_t> rows, ja;
+    std::vector<uint32_t> ia;
+
+    TiledTCSR(const TCSR&, uint_fast32_t = 0);
+
+    pprank_vec_t tdot(const pprank_vec_t&) const;
+    void tdot(const pprank_vec_t&, pprank_vec_t&) const;
+
+    uint_fast64_t index_bytes() const;
+};
+
+uint_fast32_t default_tile_size();
+
+
+#endif
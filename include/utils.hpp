@@ -1,6 +1,7 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <tuple>
@@ -8,30 +9,85 @@
 
 #include "armadillo"
 
+// the default precision of the ranks, used by all the storage formats and kernels
 #ifdef ACCURATE
 using pprank_t = double;
 using pprank_vec_t = arma::vec;
-#define PPRANK_MPI_T MPI_DOUBLE
+using pprank_mat_t = arma::mat;
 #else
 using pprank_t = float;
 using pprank_vec_t = arma::fvec;
-#define PPRANK_MPI_T MPI_FLOAT
+using pprank_mat_t = arma::fmat;
 #endif
 
+// the precisions which can be selected at runtime: the values of the matrix and the ranks both in single or double
+// precision, or the values in single precision and the ranks (and thus the sums) in double precision, or the values
+// in double precision and the ranks in single precision until they are close enough, and in double afterwards
+extern const std::vector<std::string> precisions;
 
-struct TCSR {
+// the residual below which the escalating precision switches the ranks to double precision; since the residual is
+// a sum over all the nodes, single precision can still reduce it well below this
+const double escalation_tol = 1e-5;
+
+
+template<typename V>
+struct BasicTCSR {
+    // a transition matrix whose nonzero values have type V
+    // the products accept vectors of any type R, accumulating in R (e.g. V = float and R = double)
     uint_fast32_t num_rows, num_cols;
-    std::vector<pprank_t> a;
+    std::vector<V> a;
     std::vector<uint_fast32_t> ia, ja;
     std::vector<uint_fast32_t> dangling_nodes;
 
-    TCSR();
-    TCSR(const std::string&);
+    BasicTCSR();
+    BasicTCSR(const std::string&);
+    template<typename U> explicit BasicTCSR(const BasicTCSR<U>&);
 
-    pprank_vec_t tdot(const pprank_vec_t&) const;
+    template<typename R> arma::Col<R> tdot(const arma::Col<R>&) const;
+    template<typename R> void tdot(const arma::Col<R>&, arma::Col<R>&) const;
+    template<typename R> arma::Mat<R> tdot(const arma::Mat<R>&) const;
+    template<typename R> void tdot(const arma::Mat<R>&, arma::Mat<R>&) const;
 
-    std::tuple<std::vector<uint_fast32_t>, std::vector<uint_fast32_t>, std::vector<TCSR>> split(uint_fast32_t) const;
+    std::tuple<std::vector<uint_fast32_t>, std::vector<uint_fast32_t>, std::vector<BasicTCSR>> split(
+        uint_fast32_t) const;
+
+    BasicTCSR permute(const std::vector<uint_fast32_t>&) const;
+    BasicTCSR transpose() const;
 };
 
+using TCSR = BasicTCSR<pprank_t>;
+
+uint_fast32_t cache_size();
+
+template<typename T>
+double time_tdot(const T& A, uint_fast32_t repetitions = 5)
+{
+    // return the average time (in seconds) of a matrix-vector product with the matrix transposed
+    const pprank_vec_t vec(A.num_rows, arma::fill::ones);
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint_fast32_t r = 0; r < repetitions; ++r) {
+        const pprank_vec_t res = A.tdot(vec);
+    }
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now()-start_time;
+    return duration.count()/repetitions;
+}
+
+template<typename F>
+double time_tdot_fn(const F& tdot, uint_fast32_t num_rows, uint_fast32_t num_cols, uint_fast32_t repetitions = 5)
+{
+    // same as above, for a function computing the products into a vector allocated by the caller
+    // the first product is not timed, since it also warms up the caches (and the threads, if any)
+    const pprank_vec_t vec(num_rows, arma::fill::ones);
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint_fast32_t r = 0; r < repetitions; ++r) {
+        tdot(vec, res);
+    }
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now()-start_time;
+    return duration.count()/repetitions;
+}
+
 
 #endif
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <omp.h>
+#include <unistd.h>
+
+#include "autotune.hpp"
+#include "binned.hpp"
+#include "csr5.hpp"
+#include "hybrid.hpp"
+#include "mergepath.hpp"
+#include "packed.hpp"
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include "propagation.hpp"
+#include "segmented.hpp"
+#include "simd.hpp"
+#include "solvers.hpp"
+#include "specialized.hpp"
+#include "stealing.hpp"
+#include "tiled.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+const std::vector<std::string> kernels = {
+    "csr", "segmented", "tiled", "hybrid", "packed", "propagation", "simd", "prefetch", "stealing", "mergepath",
+    "specialized", "binned", "csr5"
+};
+
+// the kernels whose work is split among a given number of threads; the others are timed once, on a single thread
+// note that hybrid, binned and csr5 split their work among the threads of OpenMP, so their products are run with
+// the number of threads of OpenMP set to the given one
+const std::vector<std::string> threaded_kernels = {"csr", "hybrid", "stealing", "mergepath", "binned", "csr5"};
+
+
+tdot_fn with_threads(const tdot_fn& tdot, uint_fast32_t num_threads)
+{
+    // run the products of a kernel using the threads of OpenMP on num_threads threads, restoring the previous
+    // number of threads afterwards (which only affects the calling thread)
+    return [tdot, num_threads](const pprank_vec_t& vec, pprank_vec_t& res) {
+        const int max_threads = omp_get_max_threads();
+        omp_set_num_threads(num_threads);
+        tdot(vec, res);
+        omp_set_num_threads(max_threads);
+    };
+}
+
+
+std::vector<Specialization>::const_iterator find_specialization(const std::string& name)
+{
+    // the specialized kernel with the given name (e.g. "u32-float-column"), or the end of the table
+    return std::find_if(specializations.begin(), specializations.end(),
+        [&name](const Specialization& specialization) { return specialization.name == name; });
+}
+
+
+tdot_fn build_kernel(const TCSR& tcsr, const std::string& kernel, uint_fast32_t num_threads)
+{
+    // build the storage format of the given kernel, owned by the returned function
+    // the kernel can also be one of the specialized kernels, built without timing the others
+    // note that the matrix is not copied, so it must outlive the returned function
+    if (kernel == "csr" and num_threads > 1) {
+        const auto threaded = std::make_shared<const ThreadedTCSR>(tcsr, num_threads);
+        return [threaded](const pprank_vec_t& vec, pprank_vec_t& res) { threaded->tdot(vec, res); };
+    }
+    else if (kernel == "segmented") {
+        const auto scsr = std::make_shared<const SegmentedTCSR>(tcsr);
+        return [scsr](const pprank_vec_t& vec, pprank_vec_t& res) { scsr->tdot(vec, res); };
+    }
+    else if (kernel == "tiled") {
+        const auto tiled = std::make_shared<const TiledTCSR>(tcsr);
+        return [tiled](const pprank_vec_t& vec, pprank_vec_t& res) { tiled->tdot(vec, res); };
+    }
+    else if (kernel == "hybrid") {
+        const auto hybrid = std::make_shared<const HybridTCSR>(tcsr);
+        return with_threads([hybrid](const pprank_vec_t& vec, pprank_vec_t& res) { hybrid->tdot(vec, res); },
+                            num_threads);
+    }
+    else if (kernel == "packed") {
+        const auto packed = std::make_shared<const PackedTCSR>(tcsr);
+        return [packed](const pprank_vec_t& vec, pprank_vec_t& res) { packed->tdot(vec, res); };
+    }
+    else if (kernel == "propagation") {
+        const auto propagation = std::make_shared<const PropagationTCSR>(tcsr);
+        return [propagation](const pprank_vec_t& vec, pprank_vec_t& res) { propagation->tdot(vec, res); };
+    }
+    else if (kernel == "simd") {
+        const auto simd = std::make_shared<const SimdTCSR>(tcsr);
+        return [simd](const pprank_vec_t& vec, pprank_vec_t& res) { simd->tdot(vec, res); };
+    }
+    else if (kernel == "prefetch") {
+        const auto prefetch = std::make_shared<const PrefetchTCSR>(tcsr);
+        return [prefetch](const pprank_vec_t& vec, pprank_vec_t& res) { prefetch->tdot(vec, res); };
+    }
+    else if (kernel == "stealing") {
+        const auto stealing = std::make_shared<const StealingTCSR>(tcsr, num_threads);
+        return [stealing](const pprank_vec_t& vec, pprank_vec_t& res) { stealing->tdot(vec, res); };
+    }
+    else if (kernel == "mergepath") {
+        const auto mergepath = std::make_shared<const MergePathTCSR>(tcsr, num_threads);
+        return [mergepath](const pprank_vec_t& vec, pprank_vec_t& res) { mergepath->tdot(vec, res); };
+    }
+    else if (kernel == "binned") {
+        const auto binned = std::make_shared<const BinnedTCSR>(tcsr);
+        return with_threads([binned](const pprank_vec_t& vec, pprank_vec_t& res) { binned->tdot(vec, res); },
+                            num_threads);
+    }
+    else if (kernel == "csr5") {
+        const auto csr5 = std::make_shared<const Csr5TCSR>(tcsr);
+        return with_threads([csr5](const pprank_vec_t& vec, pprank_vec_t& res) { csr5->tdot(vec, res); },
+                            num_threads);
+    }
+    else if (kernel == "specialized") {
+        const std::vector<double> times = calibrate_specializations(tcsr);
+        return specializations[std::min_element(times.begin(), times.end())-times.begin()].build(tcsr);
+    }
+
+    const auto specialization = find_specialization(kernel);
+    if (specialization != specializations.end()) { return specialization->build(tcsr); }
+    return [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+}
+
+
+std::vector<std::tuple<std::string, uint_fast32_t, double>> autotune(const TCSR& tcsr, uint_fast32_t max_threads,
+        uint_fast32_t repetitions)
+{
+    // time a few matrix-vector products of every kernel, with from one to max_threads threads (doubling them) if
+    // the kernel is threaded, and return the configurations sorted from the fastest
+    // note that the time to build the storage formats is not counted, since it is paid only once
+    std::vector<std::tuple<std::string, uint_fast32_t, double>> timings;
+    for (const auto& kernel : kernels) {
+        if (kernel == "specialized") {
+            // only the fastest specialized kernel is returned, under its own name, so that it can be built again
+            // without timing all of them
+            const std::vector<double> times = calibrate_specializations(tcsr, repetitions);
+            const uint_fast32_t best = std::min_element(times.begin(), times.end())-times.begin();
+            timings.emplace_back(specializations[best].name, 1, times[best]);
+            continue;
+        }
+
+        std::vector<uint_fast32_t> counts = {1};
+        if (std::find(threaded_kernels.begin(), threaded_kernels.end(), kernel) != threaded_kernels.end()) {
+            for (uint_fast32_t n = 2; n < max_threads; n *= 2) { counts.push_back(n); }
+            if (max_threads > 1) { counts.push_back(max_threads); }
+        }
+
+        for (const uint_fast32_t num_threads : counts) {
+            const tdot_fn tdot = build_kernel(tcsr, kernel, num_threads);
+            timings.emplace_back(kernel, num_threads, time_tdot_fn(tdot, tcsr.num_rows, tcsr.num_cols, repetitions));
+        }
+    }
+
+    std::stable_sort(timings.begin(), timings.end(),
+        [](const std::tuple<std::string, uint_fast32_t, double>& lhs,
+           const std::tuple<std::string, uint_fast32_t, double>& rhs) { return std::get<2>(lhs) < std::get<2>(rhs); });
+    return timings;
+}
+
+
+std::string graph_fingerprint(const TCSR& tcsr)
+{
+    // identify the graph by its size and a 64-bit FNV-1a hash of its structure (the nonzero values only depend on
+    // it), so that a reordered graph gets a different fingerprint
+    uint64_t hash = UINT64_C(14695981039346656037);
+    const auto combine = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= UINT64_C(1099511628211);
+    };
+    combine(tcsr.num_rows);
+    combine(tcsr.num_cols);
+    for (const auto i : tcsr.ia) { combine(i); }
+    for (const auto j : tcsr.ja) { combine(j); }
+
+    std::ostringstream fingerprint;
+    fingerprint << tcsr.num_rows << "-" << tcsr.a.size() << "-";
+    fingerprint << std::hex << std::setfill('0') << std::setw(16) << hash;
+    return fingerprint.str();
+}
+
+std::string host_name()
+{
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name)-1) != 0 or name[0] == '\0') { return "localhost"; }
+    return name;
+}
+
+
+std::tuple<std::string, uint_fast32_t> load_tuning(const std::string& path, const std::string& host,
+        const std::string& fingerprint, uint_fast32_t max_threads)
+{
+    // return the kernel and number of threads cached for the given graph and host when autotuned with max_threads
+    // threads and ranks of the same type, or an empty kernel if there are none; since save_tuning() appends, the
+    // last matching line wins
+    // note that a kernel using more than max_threads threads, or a specialized one for values of another type, is
+    // never returned, even from a corrupted file
+    std::string kernel;
+    uint_fast32_t num_threads = 0;
+
+    std::ifstream infile(path);
+    std::string line;
+    while (std::getline(infile, line)) {
+        std::istringstream fields(line);
+        std::string line_host, line_fingerprint, line_kernel;
+        uint_fast32_t line_max_threads, line_value_bits, line_threads;
+        if (not (fields >> line_host >> line_fingerprint >> line_max_threads >> line_value_bits >> line_kernel >>
+                 line_threads)) {
+            continue;
+        }
+        if (line_host != host or line_fingerprint != fingerprint or line_max_threads != max_threads or
+                line_value_bits != 8*sizeof(pprank_t)) {
+            continue;
+        }
+        const auto specialization = find_specialization(line_kernel);
+        if (std::find(kernels.begin(), kernels.end(), line_kernel) == kernels.end() and
+                (specialization == specializations.end() or specialization->value_bits != 8*sizeof(pprank_t))) {
+            continue;
+        }
+        if (line_threads == 0 or line_threads > max_threads) { continue; }
+
+        kernel = line_kernel;
+        num_threads = line_threads;
+    }
+    return std::make_tuple(kernel, num_threads);
+}
+
+void save_tuning(const std::string& path, const std::string& host, const std::string& fingerprint,
+        uint_fast32_t max_threads, const std::string& kernel, uint_fast32_t num_threads)
+{
+    std::ofstream outfile(path, std::ios::app);
+    outfile << host << " " << fingerprint << " " << max_threads << " " << 8*sizeof(pprank_t) << " " << kernel << " ";
+    outfile << num_threads << std::endl;
+}
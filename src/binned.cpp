@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "binned.hpp"
+#include "hybrid.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+using hrc = std::chrono::high_resolution_clock;
+
+
+const std::vector<std::string> bin_names = {"tiny", "medium", "huge"};
+
+constexpr uint_fast32_t BinnedTCSR::tiny_degree;
+constexpr uint_fast32_t BinnedTCSR::segment_size;
+
+
+// each kernel computes res[j] = sum_k a[k]*vec[ja[k]] for the rows j of the transposed matrix in its bin
+
+template<uint_fast32_t D>
+void pull_tiny(const RowBin& bin, const pprank_t* vec, pprank_t* res)
+{
+    // all the rows have exactly D nonzero values, so the inner loop has a fixed length and is fully unrolled
+    const uint_fast32_t num_rows = bin.rows.size();
+    #pragma omp parallel for schedule(static)
+    for (uint_fast32_t r = 0; r < num_rows; ++r) {
+        pprank_t sum = 0;
+        for (uint_fast32_t d = 0; d < D; ++d) {
+            sum += bin.a[r*D+d] * vec[bin.ja[r*D+d]];
+        }
+        res[bin.rows[r]] = sum;
+    }
+}
+
+using tiny_kernel = void (*)(const RowBin&, const pprank_t*, pprank_t*);
+const tiny_kernel tiny_kernels[] = {
+    pull_tiny<0>, pull_tiny<1>, pull_tiny<2>, pull_tiny<3>, pull_tiny<4>, pull_tiny<5>, pull_tiny<6>, pull_tiny<7>,
+    pull_tiny<8>
+};
+static_assert(sizeof(tiny_kernels)/sizeof(tiny_kernels[0]) == BinnedTCSR::tiny_degree+1,
+              "one tiny kernel for each degree");
+
+inline pprank_t pull_range(const RowBin& bin, uint_fast32_t begin, uint_fast32_t end, const pprank_t* vec)
+{
+    // the dot product of the nonzero values in [begin, end) with the input vector, vectorized with gathers
+    pprank_t sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (uint_fast32_t k = begin; k < end; ++k) {
+        sum += bin.a[k] * vec[bin.ja[k]];
+    }
+    return sum;
+}
+
+
+BinnedTCSR::BinnedTCSR(const TCSR& tcsr, uint_fast32_t huge_threshold) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), huge_threshold(huge_threshold), tiny_bins(tiny_degree+1),
+    bin_time(bin_names.size(), 0.0)
+{
+    assert(num_rows <= std::numeric_limits<uint32_t>::max());
+    const TCSR at = tcsr.transpose();
+    if (this->huge_threshold == 0) { this->huge_threshold = default_hub_threshold(at); }
+    this->huge_threshold = std::max(this->huge_threshold, tiny_degree);
+
+    // append each row of the transposed matrix to its bin, in increasing order
+    medium_bin.ia.push_back(0);
+    huge_bin.ia.push_back(0);
+    for (uint_fast32_t j = 0; j < num_cols; ++j) {
+        const uint_fast32_t degree = at.ia[j+1]-at.ia[j];
+        RowBin& bin = degree <= tiny_degree ? tiny_bins[degree] :
+                      degree <= this->huge_threshold ? medium_bin : huge_bin;
+        bin.rows.push_back(j);
+        bin.a.insert(bin.a.end(), at.a.begin()+at.ia[j], at.a.begin()+at.ia[j+1]);
+        bin.ja.insert(bin.ja.end(), at.ja.begin()+at.ia[j], at.ja.begin()+at.ia[j+1]);
+        if (degree > tiny_degree) { bin.ia.push_back(bin.ja.size()); }
+    }
+
+    // split the huge rows into segments, so that even a single huge row is computed by all the threads
+    for (uint_fast32_t r = 0; r < huge_bin.rows.size(); ++r) {
+        for (uint_fast32_t k = huge_bin.ia[r]; k < huge_bin.ia[r+1]; k += segment_size) {
+            segment_rows.push_back(r);
+            segment_starts.push_back(k);
+        }
+    }
+    segment_sums.resize(segment_rows.size());
+}
+
+pprank_vec_t BinnedTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void BinnedTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    // every entry of the result is written by exactly one bin, so it does not need to be cleared first
+    assert(res.n_elem == num_cols);
+    const pprank_t* vec_ptr = vec.memptr();
+    pprank_t* res_ptr = res.memptr();
+
+    auto start_time = hrc::now();
+    for (uint_fast32_t d = 0; d <= tiny_degree; ++d) {
+        tiny_kernels[d](tiny_bins[d], vec_ptr, res_ptr);
+    }
+    std::chrono::duration<double> duration = hrc::now()-start_time;
+    bin_time[0] += duration.count();
+
+    start_time = hrc::now();
+    const uint_fast32_t num_medium = medium_bin.rows.size();
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (uint_fast32_t r = 0; r < num_medium; ++r) {
+        res_ptr[medium_bin.rows[r]] = pull_range(medium_bin, medium_bin.ia[r], medium_bin.ia[r+1], vec_ptr);
+    }
+    duration = hrc::now()-start_time;
+    bin_time[1] += duration.count();
+
+    start_time = hrc::now();
+    const uint_fast32_t num_segments = segment_rows.size();
+    #pragma omp parallel for schedule(dynamic)
+    for (uint_fast32_t s = 0; s < num_segments; ++s) {
+        const uint_fast32_t row_end = huge_bin.ia[segment_rows[s]+1];
+        const uint_fast32_t end = std::min<uint_fast32_t>(segment_starts[s]+segment_size, row_end);
+        segment_sums[s] = pull_range(huge_bin, segment_starts[s], end, vec_ptr);
+    }
+    for (const auto j : huge_bin.rows) { res_ptr[j] = 0; }
+    for (uint_fast32_t s = 0; s < num_segments; ++s) {
+        res_ptr[huge_bin.rows[segment_rows[s]]] += segment_sums[s];
+    }
+    duration = hrc::now()-start_time;
+    bin_time[2] += duration.count();
+}
+
+void BinnedTCSR::reset_stats() const
+{
+    std::fill(bin_time.begin(), bin_time.end(), 0.0);
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "csr5.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+constexpr uint_fast32_t Csr5TCSR::omega;
+constexpr uint_fast32_t Csr5TCSR::sigma;
+constexpr uint_fast32_t Csr5TCSR::tile_size;
+
+
+Csr5TCSR::Csr5TCSR(const TCSR& tcsr) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols)
+{
+    assert(num_rows <= std::numeric_limits<uint32_t>::max());
+    const TCSR at = tcsr.transpose();
+    const uint_fast64_t num_values = at.a.size();
+    const uint_fast32_t num_tiles = (num_values+tile_size-1)/tile_size;
+
+    // store each tile transposed, padding the last one with zeros
+    a.assign(((uint_fast64_t) num_tiles)*tile_size, 0);
+    ja.assign(((uint_fast64_t) num_tiles)*tile_size, 0);
+    for (uint_fast64_t k = 0; k < num_values; ++k) {
+        const uint_fast32_t e = k%tile_size;
+        const uint_fast64_t dst = k-e + (e%sigma)*omega + e/sigma;
+        a[dst] = at.a[k];
+        ja[dst] = at.ja[k];
+    }
+
+    // flag the first nonzero value of each row, and collect the empty rows
+    bit_flag.assign(num_tiles, 0);
+    y_offset.assign(((uint_fast64_t) num_tiles)*omega, 0);
+    for (uint_fast32_t j = 0; j < num_cols; ++j) {
+        if (at.ia[j] == at.ia[j+1]) {
+            empty_rows.push_back(j);
+            continue;
+        }
+        const uint_fast64_t k = at.ia[j];
+        const uint_fast32_t t = k/tile_size, e = k%tile_size;
+        bit_flag[t] |= UINT64_C(1) << ((e%sigma)*omega + e/sigma);
+        for (uint_fast32_t l = e/sigma+1; l < omega; ++l) { ++y_offset[t*omega+l]; }
+    }
+
+    // find the row of the first and last nonzero values of each tile: if there are empty rows in between, the rows
+    // starting in the tile are not consecutive, so they are listed explicitly
+    tile_ptr.resize(num_tiles);
+    empty_ptr.push_back(0);
+    for (uint_fast32_t t = 0; t < num_tiles; ++t) {
+        const uint_fast64_t first = ((uint_fast64_t) t)*tile_size;
+        const uint_fast64_t last = std::min(first+tile_size, num_values)-1;
+        tile_ptr[t] = std::upper_bound(at.ia.begin(), at.ia.end(), first)-at.ia.begin()-1;
+        const uint_fast32_t last_row = std::upper_bound(at.ia.begin(), at.ia.end(), last)-at.ia.begin()-1;
+
+        const uint_fast32_t first_start = (bit_flag[t] & 1) ? tile_ptr[t] : tile_ptr[t]+1;
+        if (last_row+1-first_start != (uint_fast32_t) __builtin_popcountll(bit_flag[t])) {
+            for (uint_fast32_t j = first_start; j <= last_row; ++j) {
+                if (at.ia[j] < at.ia[j+1]) { empty_offset.push_back(j); }
+            }
+        }
+        empty_ptr.push_back(empty_offset.size());
+    }
+    carry.resize(num_tiles);
+}
+
+pprank_vec_t Csr5TCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void Csr5TCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    // every non-empty row starts in exactly one tile, which writes its entry of the result, so the tiles can be
+    // computed in parallel; the sums carried over the boundaries of the tiles are added afterwards
+    assert(res.n_elem == num_cols);
+    const pprank_t* vec_ptr = vec.memptr();
+    pprank_t* res_ptr = res.memptr();
+    const uint_fast32_t num_tiles = tile_ptr.size();
+    const uint64_t lane_mask = (UINT64_C(1) << omega)-1;
+
+    #pragma omp parallel for schedule(static)
+    for (uint_fast32_t t = 0; t < num_tiles; ++t) {
+        const pprank_t* a_t = a.data()+((uint_fast64_t) t)*tile_size;
+        const uint32_t* ja_t = ja.data()+((uint_fast64_t) t)*tile_size;
+        const uint8_t* y_offset_t = y_offset.data()+((uint_fast64_t) t)*omega;
+        const bool dirty = empty_ptr[t] < empty_ptr[t+1];
+        const uint_fast32_t first_row = (bit_flag[t] & 1) ? tile_ptr[t] : tile_ptr[t]+1;
+        const auto row = [&](uint_fast32_t r) { return dirty ? empty_offset[empty_ptr[t]+r] : first_row+r; };
+
+        // the segmented sum of each lane, all the lanes at once: at every step, a lane whose value starts a row
+        // saves the sum of its previous segment and restarts from the new value
+        pprank_t sums[omega] = {}, closed[tile_size];
+        for (uint_fast32_t s = 0; s < sigma; ++s) {
+            const uint64_t flags = (bit_flag[t] >> (s*omega)) & lane_mask;
+            #pragma omp simd
+            for (uint_fast32_t l = 0; l < omega; ++l) {
+                const pprank_t product = a_t[s*omega+l] * vec_ptr[ja_t[s*omega+l]];
+                const bool starts = (flags >> l) & 1;
+                closed[s*omega+l] = sums[l];
+                sums[l] = starts ? product : sums[l]+product;
+            }
+        }
+
+        // the segments closed by the second and later row starts of a lane are whole rows, while the one closed by
+        // its first row start (its head) continues a row from the previous lanes
+        pprank_t heads[omega];
+        uint8_t starts[omega] = {};
+        for (uint64_t flags = bit_flag[t]; flags; flags &= flags-1) {
+            const uint_fast32_t b = __builtin_ctzll(flags), l = b%omega;
+            if (starts[l] == 0) { heads[l] = closed[b]; }
+            else { res_ptr[row(y_offset_t[l]+starts[l]-1)] = closed[b]; }
+            ++starts[l];
+        }
+
+        // the row open at the end of a lane continues through the next lanes without row starts, up to the head of
+        // the next lane with one (the role of seg_offset in the paper); the first of these rows continues from the
+        // previous tiles, and the last one into the next tiles
+        pprank_t open = 0;
+        bool carried = true;
+        uint_fast32_t open_row = 0;
+        for (uint_fast32_t l = 0; l < omega; ++l) {
+            if (starts[l] == 0) {
+                open += sums[l];
+                continue;
+            }
+            open += heads[l];
+            if (carried) { carry[t] = open; }
+            else { res_ptr[open_row] = open; }
+            carried = false;
+            open_row = row(y_offset_t[l]+starts[l]-1);
+            open = sums[l];
+        }
+        if (carried) { carry[t] = open; }
+        else { res_ptr[open_row] = open; }
+    }
+
+    for (const auto j : empty_rows) { res_ptr[j] = 0; }
+    for (uint_fast32_t t = 0; t < num_tiles; ++t) {
+        if (not (bit_flag[t] & 1)) { res_ptr[tile_ptr[t]] += carry[t]; }
+    }
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "hybrid.hpp"
+#include "segmented.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+uint_fast32_t default_hub_threshold(const TCSR& tcsr)
+{
+    // a row is a hub if it has many more nonzero values than the average row
+    const uint_fast32_t avg_degree = tcsr.ja.size()/std::max<uint_fast32_t>(tcsr.num_rows, 1);
+    return std::max<uint_fast32_t>(64*avg_degree, 1024);
+}
+
+
+HybridTCSR::HybridTCSR(const TCSR& tcsr, uint_fast32_t hub_threshold, uint_fast32_t chunk_size) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols),
+    hub_threshold(hub_threshold > 0 ? hub_threshold : default_hub_threshold(tcsr)),
+    chunk_size(chunk_size > 0 ? chunk_size : default_segment_size())
+{
+    // find the hubs
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        if (tcsr.ia[i+1]-tcsr.ia[i] > this->hub_threshold) { hubs.push_back(i); }
+    }
+
+    // copy all the other rows, leaving the rows of the hubs empty
+    regular.num_rows = num_rows;
+    regular.num_cols = num_cols;
+    regular.dangling_nodes = tcsr.dangling_nodes;
+    regular.ia.reserve(tcsr.ia.size());
+    regular.ia.push_back(0);
+    for (uint_fast32_t i = 0, h = 0; i < num_rows; ++i) {
+        if (h < hubs.size() and hubs[h] == i) {
+            ++h;
+        }
+        else {
+            regular.a.insert(regular.a.end(), tcsr.a.begin()+tcsr.ia[i], tcsr.a.begin()+tcsr.ia[i+1]);
+            regular.ja.insert(regular.ja.end(), tcsr.ja.begin()+tcsr.ia[i], tcsr.ja.begin()+tcsr.ia[i+1]);
+        }
+        regular.ia.push_back(regular.ja.size());
+    }
+
+    // group the nonzero values of the hubs by chunk of columns, counting them first
+    const uint_fast32_t num_chunks = (num_cols+this->chunk_size-1)/this->chunk_size;
+    hub_ia.assign(num_chunks*hubs.size()+1, 0);
+    for (uint_fast32_t h = 0; h < hubs.size(); ++h) {
+        for (uint_fast32_t k = tcsr.ia[hubs[h]]; k < tcsr.ia[hubs[h]+1]; ++k) {
+            ++hub_ia[tcsr.ja[k]/this->chunk_size*hubs.size()+h+1];
+        }
+    }
+    for (uint_fast32_t b = 0; b+1 < hub_ia.size(); ++b) {
+        hub_ia[b+1] += hub_ia[b];
+    }
+
+    hub_a.resize(hub_ia.back());
+    hub_ja.resize(hub_ia.back());
+    std::vector<uint_fast32_t> next(hub_ia.begin(), hub_ia.end()-1);
+    for (uint_fast32_t h = 0; h < hubs.size(); ++h) {
+        for (uint_fast32_t k = tcsr.ia[hubs[h]]; k < tcsr.ia[hubs[h]+1]; ++k) {
+            const uint_fast32_t dst = next[tcsr.ja[k]/this->chunk_size*hubs.size()+h]++;
+            hub_a[dst] = tcsr.a[k];
+            hub_ja[dst] = tcsr.ja[k];
+        }
+    }
+    assert(regular.a.size()+hub_a.size() == tcsr.a.size());
+}
+
+pprank_vec_t HybridTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void HybridTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    regular.tdot(vec, res);
+    if (hubs.empty()) { return; }
+
+    // the chunks of the hubs write into disjoint ranges of the result, so they can be processed in parallel
+    const uint_fast32_t num_hubs = hubs.size();
+    const uint_fast32_t num_chunks = (hub_ia.size()-1)/num_hubs;
+    #pragma omp parallel for schedule(dynamic)
+    for (uint_fast32_t c = 0; c < num_chunks; ++c) {
+        for (uint_fast32_t h = 0; h < num_hubs; ++h) {
+            const pprank_t vec_h = vec[hubs[h]];
+            const uint_fast32_t b = c*num_hubs+h;
+            for (uint_fast32_t k = hub_ia[b]; k < hub_ia[b+1]; ++k) {
+                res[hub_ja[k]] += hub_a[k] * vec_h;
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "mergepath.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+std::tuple<uint_fast32_t, uint_fast32_t> merge_path_search(const TCSR& tcsr, uint_fast64_t diagonal)
+{
+    // find where the given diagonal crosses the merge path of the row end offsets (ia[1], ..., ia[num_rows]) and of
+    // the indices of the nonzero values (0, ..., nnz-1), returning the coordinates (row, nonzero value) of the point
+    // note that the path always consumes a row end offset before the nonzero values equal to or past it
+    const uint_fast64_t nnz = tcsr.ja.size();
+    uint_fast64_t x_min = diagonal > nnz ? diagonal-nnz : 0, x_max = std::min<uint_fast64_t>(diagonal, tcsr.num_rows);
+    while (x_min < x_max) {
+        const uint_fast64_t pivot = (x_min+x_max)/2;
+        if (tcsr.ia[pivot+1] <= diagonal-pivot-1) { x_min = pivot+1; }
+        else { x_max = pivot; }
+    }
+    return std::make_tuple(x_min, diagonal-x_min);
+}
+
+
+MergePathTCSR::MergePathTCSR(const TCSR& tcsr, uint_fast32_t num_threads) :
+    at(tcsr.transpose()), num_rows(tcsr.num_rows), num_cols(tcsr.num_cols),
+    num_threads(std::max<uint_fast32_t>(num_threads, 1)), row_starts(this->num_threads+1),
+    nz_starts(this->num_threads+1), carry_rows(this->num_threads), carry_values(this->num_threads)
+{
+    // since the matrix does not change, the starting point of each thread is searched only once
+    const uint_fast64_t length = ((uint_fast64_t) at.num_rows)+at.ja.size();
+    for (uint_fast32_t t = 0; t <= this->num_threads; ++t) {
+        std::tie(row_starts[t], nz_starts[t]) = merge_path_search(at, length*t/this->num_threads);
+    }
+}
+
+pprank_vec_t MergePathTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void MergePathTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    #pragma omp parallel num_threads(num_threads)
+    {
+#ifdef _OPENMP
+        const uint_fast32_t t = omp_get_thread_num(), n = omp_get_num_threads();
+#else
+        const uint_fast32_t t = 0, n = 1;
+#endif
+        // note that the runtime could provide fewer threads than requested, so the parts are distributed cyclically
+        for (uint_fast32_t p = t; p < num_threads; p += n) {
+            uint_fast32_t k = nz_starts[p];
+
+            // the rows ending in this part, the first of which could have started in a previous part...
+            for (uint_fast32_t j = row_starts[p]; j < row_starts[p+1]; ++j) {
+                pprank_t sum = 0;
+                for (; k < at.ia[j+1]; ++k) {
+                    sum += at.a[k] * vec[at.ja[k]];
+                }
+                res[j] = sum;
+            }
+
+            // ...and the beginning of the row continuing in the next part
+            pprank_t sum = 0;
+            for (; k < nz_starts[p+1]; ++k) {
+                sum += at.a[k] * vec[at.ja[k]];
+            }
+            carry_rows[p] = row_starts[p+1];
+            carry_values[p] = sum;
+        }
+    }
+
+    // add the partial sums of the rows split between parts
+    for (uint_fast32_t p = 0; p < num_threads; ++p) {
+        if (carry_rows[p] < num_cols) { res[carry_rows[p]] += carry_values[p]; }
+    }
+}
@@ -0,0 +1,109 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PPRANK_X86
+#include <immintrin.h>
+#endif
+
+#include "packed.hpp"
+#include "simd.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+// each kernel computes res += A^T vec, unpacking the column indices of the matrix
+
+void scatter_scalar(const PackedTCSR& A, const pprank_t* vec, pprank_t* res)
+{
+    for (uint_fast32_t i = 0; i < A.num_rows; ++i) {
+        const pprank_t vec_i = vec[i];
+        for (uint_fast32_t k = A.ia[i]; k < A.ia[i+1]; ++k) {
+            res[A.col(k)] += A.a[k] * vec_i;
+        }
+    }
+}
+
+#ifdef PPRANK_X86
+__attribute__((target("avx2")))
+void scatter_avx2(const PackedTCSR& A, const pprank_t* vec, pprank_t* res)
+{
+    // the column indices are unpacked four at a time, gathering the 8 bytes containing each one
+    const long long* bytes = (const long long*) A.packed_ja.data();
+    const __m256i lanes = _mm256_setr_epi64x(0, A.bits, 2*A.bits, 3*A.bits);
+    const __m256i mask = _mm256_set1_epi64x((UINT64_C(1) << A.bits)-1), seven = _mm256_set1_epi64x(7);
+    alignas(32) uint64_t cols[4];
+    for (uint_fast32_t i = 0; i < A.num_rows; ++i) {
+        const pprank_t vec_i = vec[i];
+        uint_fast32_t k = A.ia[i];
+        for (; k+4 <= A.ia[i+1]; k += 4) {
+            const __m256i bit = _mm256_add_epi64(_mm256_set1_epi64x(((uint_fast64_t) k)*A.bits), lanes);
+            const __m256i words = _mm256_i64gather_epi64(bytes, _mm256_srli_epi64(bit, 3), 1);
+            const __m256i shift = _mm256_and_si256(bit, seven);
+            _mm256_store_si256((__m256i*) cols, _mm256_and_si256(_mm256_srlv_epi64(words, shift), mask));
+            res[cols[0]] += A.a[k] * vec_i;
+            res[cols[1]] += A.a[k+1] * vec_i;
+            res[cols[2]] += A.a[k+2] * vec_i;
+            res[cols[3]] += A.a[k+3] * vec_i;
+        }
+        for (; k < A.ia[i+1]; ++k) {
+            res[A.col(k)] += A.a[k] * vec_i;
+        }
+    }
+}
+#endif
+
+
+PackedTCSR::PackedTCSR(const TCSR& tcsr) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), bits(1), a(tcsr.a), ia(tcsr.ia)
+{
+    // pack the column indices of a matrix with a fixed width of ceil(log2(num_cols)) bits
+    // note that the bits are stored from the least significant one, so reading them back assumes little-endian
+    while (bits < 32 and (UINT64_C(1) << bits) < num_cols) {
+        ++bits;
+    }
+
+    const uint_fast64_t num_bits = ((uint_fast64_t) tcsr.ja.size())*bits;
+    packed_ja.assign(num_bits/64+2, 0);
+    for (uint_fast64_t k = 0; k < tcsr.ja.size(); ++k) {
+        const uint_fast64_t bit = k*bits;
+        const uint_fast32_t word = bit/64, offset = bit%64;
+        packed_ja[word] |= ((uint64_t) tcsr.ja[k]) << offset;
+        if (offset+bits > 64) { packed_ja[word+1] |= ((uint64_t) tcsr.ja[k]) >> (64-offset); }
+    }
+
+    // the kernel is chosen once, among the instruction sets supported by the processor (via CPUID)
+    kernel = scatter_scalar;
+#ifdef PPRANK_X86
+    if (supports_isa("avx2")) { kernel = scatter_avx2; }
+#endif
+}
+
+uint_fast32_t PackedTCSR::col(uint_fast32_t k) const
+{
+    // unpack the column index of the k-th nonzero value without branches: since an index spans at most 32 bits,
+    // it is always contained in the 8 bytes starting from its first byte
+    const uint_fast64_t bit = ((uint_fast64_t) k)*bits;
+    uint64_t word;
+    std::memcpy(&word, ((const char*) packed_ja.data())+bit/8, sizeof(word));
+    return (word >> (bit%8)) & ((UINT64_C(1) << bits)-1);
+}
+
+pprank_vec_t PackedTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void PackedTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    res.zeros();
+    kernel(*this, vec.memptr(), res.memptr());
+}
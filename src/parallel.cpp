@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "parallel.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+uint_fast32_t max_threads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+template<typename V>
+std::vector<uint_fast32_t> balanced_bounds(const BasicTCSR<V>& tcsr, uint_fast32_t n)
+{
+    // split the rows of a matrix into n blocks with about the same number of nonzero values
+    // block b contains the rows [bounds[b], bounds[b+1])
+    assert(n > 0);
+    std::vector<uint_fast32_t> bounds(n+1);
+    for (uint_fast32_t b = 0; b < n; ++b) {
+        const uint_fast64_t target = ((uint_fast64_t) tcsr.ja.size())*b/n;
+        bounds[b] = std::lower_bound(tcsr.ia.begin(), tcsr.ia.end()-1, target)-tcsr.ia.begin();
+    }
+    bounds[n] = tcsr.num_rows;
+    return bounds;
+}
+
+
+template<typename V, typename R>
+BasicThreadedTCSR<V, R>::BasicThreadedTCSR(const BasicTCSR<V>& tcsr, uint_fast32_t num_threads) :
+    tcsr(tcsr), num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), num_threads(std::max<uint_fast32_t>(num_threads, 1)),
+    bounds(balanced_bounds(tcsr, this->num_threads)), buffers(this->num_threads, arma::Col<R>(tcsr.num_cols))
+{
+}
+
+template<typename V, typename R>
+arma::Col<R> BasicThreadedTCSR<V, R>::tdot(const arma::Col<R>& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    arma::Col<R> res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+template<typename V, typename R>
+void BasicThreadedTCSR<V, R>::tdot(const arma::Col<R>& vec, arma::Col<R>& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    if (num_threads == 1) { return tcsr.tdot(vec, res); }
+
+    assert(res.n_elem == num_cols);
+    #pragma omp parallel num_threads(num_threads)
+    {
+#ifdef _OPENMP
+        const uint_fast32_t t = omp_get_thread_num(), n = omp_get_num_threads();
+#else
+        const uint_fast32_t t = 0, n = 1;
+#endif
+        // each thread scatters the contributions of its rows into its own buffer...
+        // note that the runtime could provide fewer threads than requested, so the blocks are distributed cyclically
+        for (uint_fast32_t b = t; b < num_threads; b += n) {
+            R* buffer = buffers[b].memptr();
+            std::fill(buffer, buffer+num_cols, 0);
+            for (uint_fast32_t i = bounds[b]; i < bounds[b+1]; ++i) {
+                const R vec_i = vec[i];
+                for (uint_fast32_t k = tcsr.ia[i]; k < tcsr.ia[i+1]; ++k) {
+                    buffer[tcsr.ja[k]] += tcsr.a[k] * vec_i;
+                }
+            }
+        }
+        #pragma omp barrier
+
+        // ...then each thread sums a range of entries of all the buffers
+        const uint_fast32_t first = ((uint_fast64_t) num_cols)*t/n, last = ((uint_fast64_t) num_cols)*(t+1)/n;
+        for (uint_fast32_t j = first; j < last; ++j) {
+            R sum = 0;
+            for (uint_fast32_t b = 0; b < num_threads; ++b) {
+                sum += buffers[b][j];
+            }
+            res[j] = sum;
+        }
+    }
+}
+
+
+// the instantiations for the runtime precisions
+template std::vector<uint_fast32_t> balanced_bounds(const BasicTCSR<float>&, uint_fast32_t);
+template std::vector<uint_fast32_t> balanced_bounds(const BasicTCSR<double>&, uint_fast32_t);
+template struct BasicThreadedTCSR<float>;
+template struct BasicThreadedTCSR<double>;
+template struct BasicThreadedTCSR<float, double>;
+template struct BasicThreadedTCSR<double, float>;
@@ -1,13 +1,25 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <string>
 #include <tuple>
+#include <vector>
 
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "parallel.hpp"
+#include "reorder.hpp"
+#include "solvers.hpp"
 #include "utils.hpp"
 
 #include "armadillo"
@@ -22,38 +34,86 @@ int rank;
 int num_processes;
 
 
-std::tuple<uint_fast32_t, double, double, pprank_vec_t> pagerank(const TCSR& A, const pprank_t tol)
+inline MPI_Datatype mpi_datatype(float) { return MPI_FLOAT; }
+inline MPI_Datatype mpi_datatype(double) { return MPI_DOUBLE; }
+
+
+template<typename V, typename R>
+std::tuple<uint_fast32_t, uint_fast32_t, bool, double, double, arma::vec> pagerank(const BasicTCSR<V>& A,
+        const double tol, const uint_fast32_t num_threads, const std::string& method, const uint_fast32_t restart,
+        const uint_fast32_t extrapolation_period, const arma::vec& p_init = arma::vec())
 {
+    // the nonzero values have type V, while the ranks (and thus the sums) have type R
+    // the iterations start from p_init, if given, and from the uniform distribution otherwise
+    // returns the number of iterations (or of matrix-vector products, for the Krylov solvers) and of extrapolations,
+    // whether the residual fell below tol (which the Krylov solvers may not reach), the work and network times, and
+    // the ranks
     assert(A.num_rows == A.num_cols);
 
     // initialization
     const uint_fast32_t N = A.num_rows;
-    const pprank_t d = 0.85;
-    const pprank_vec_t ones(N, arma::fill::ones);
-    const arma::uvec dangling_nodes = arma::conv_to<arma::uvec>::from(A.dangling_nodes);
-
-    pprank_vec_t p(N), p_new(N);
-    p_new.fill(1.0/N);
+    const R d = 0.85;
 
     // partition the matrix in blocks of rows
     std::vector<uint_fast32_t> displacements, sizes;
-    std::vector<TCSR> tcsrs;
+    std::vector<BasicTCSR<V>> tcsrs;
     std::tie(displacements, sizes, tcsrs) = A.split(num_processes);
 
+    // the local block of rows is further split among the threads of the node
+    const BasicThreadedTCSR<V, R> A_sub(tcsrs[rank], num_threads);
+
+    // all the vectors are allocated before the first iteration, and p and p_new are swapped instead of copied
+    arma::Col<R> p(N), p_new(N), p_sub(sizes[rank]), At_dot_p_sub(N), At_dot_p(N);
+    if (p_init.n_elem == N) { p_new = arma::conv_to<arma::Col<R>>::from(p_init); }
+    else { p_new.fill(1.0/N); }
+
+    if (method != "power") {
+        // solve the PageRank linear system with GMRES or BiCGSTAB, whose matrix-vector products are computed like
+        // the ones of the power iteration below
+        // every node then has the whole product, and runs the rest of the solver on its own copy of all the
+        // vectors, in the same way as the others
+        double netw_time = 0.0;
+        const basic_tdot_fn<R> tdot = [&](const arma::Col<R>& vec, arma::Col<R>& res) {
+            std::copy(vec.memptr()+displacements[rank], vec.memptr()+displacements[rank]+sizes[rank],
+                      p_sub.memptr());
+            A_sub.tdot(p_sub, At_dot_p_sub);
+
+            const double start_time = MPI_Wtime();
+            MPI_Allreduce(At_dot_p_sub.memptr(), res.memptr(), N, mpi_datatype(R()), MPI_SUM, MPI_COMM_WORLD);
+            netw_time += MPI_Wtime()-start_time;
+        };
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        const double start_time = MPI_Wtime();
+        uint_fast32_t products;
+        bool converged;
+        if (method == "gmres") { std::tie(products, converged, p) = pagerank_gmres(A, tdot, tol, restart, p_new); }
+        else { std::tie(products, converged, p) = pagerank_bicgstab(A, tdot, tol, p_new); }
+        const double work_time = MPI_Wtime()-start_time-netw_time;
+
+        return std::make_tuple(products, 0, converged, work_time, netw_time, arma::conv_to<arma::vec>::from(p));
+    }
+
+    // every node has all the ranks, and extrapolates them in the same way
+    QuadraticExtrapolation<R> extrapolation(extrapolation_period, N);
+
     MPI_Barrier(MPI_COMM_WORLD);
 
     // ranks computation
     double start_time, work_time = 0.0, netw_time = 0.0;
     uint_fast32_t iterations = 0;
+    double residual;
     do {
         ++iterations;
-        p = p_new;
+        p.swap(p_new);
 
         // each node calculates a partial result of the matrix-vector product
         start_time = MPI_Wtime();
 
-        const TCSR A_sub = tcsrs[rank];
-        const pprank_vec_t At_dot_p_sub = A_sub.tdot(p);
+        // note that the rows of the local block are numbered from zero, so they need the matching slice of p
+        std::copy(p.memptr()+displacements[rank], p.memptr()+displacements[rank]+sizes[rank], p_sub.memptr());
+        A_sub.tdot(p_sub, At_dot_p_sub);
 
         work_time += MPI_Wtime()-start_time;
         ////////////////////////////////////////////////////////////////////////
@@ -62,8 +122,7 @@ std::tuple<uint_fast32_t, double, double, pprank_vec_t> pagerank(const TCSR& A,
         // each node must receive the contributions from all the others (very heavy!)
         start_time = MPI_Wtime();
 
-        pprank_vec_t At_dot_p(N);
-        MPI_Allreduce(At_dot_p_sub.memptr(), At_dot_p.memptr(), N, PPRANK_MPI_T, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(At_dot_p_sub.memptr(), At_dot_p.memptr(), N, mpi_datatype(R()), MPI_SUM, MPI_COMM_WORLD);
 
         netw_time += MPI_Wtime()-start_time;
         ////////////////////////////////////////////////////////////////////////
@@ -71,14 +130,22 @@ std::tuple<uint_fast32_t, double, double, pprank_vec_t> pagerank(const TCSR& A,
         // update PageRanks
         start_time = MPI_Wtime();
 
-        At_dot_p += arma::sum(p(dangling_nodes))/N * ones;
+        double dangling_sum = 0;
+        for (const auto i : A.dangling_nodes) { dangling_sum += p[i]; }
 
-        p_new = (1.0-d)/N * ones + d * At_dot_p;
+        const R base = (1.0-d)/N + d*dangling_sum/N;
+        residual = 0;
+        for (uint_fast32_t j = 0; j < N; ++j) {
+            p_new[j] = base + d*At_dot_p[j];
+            residual += std::abs(p_new[j]-p[j]);
+        }
+        if (residual >= tol) { extrapolation.step(iterations, p_new); }
 
         work_time += MPI_Wtime()-start_time;
     }
-    while (arma::norm(p_new-p, 1) >= tol);
-    return std::make_tuple(iterations, work_time, netw_time, p_new);
+    while (residual >= tol);
+    return std::make_tuple(iterations, extrapolation.extrapolations, true, work_time, netw_time,
+                           arma::conv_to<arma::vec>::from(p_new));
 }
 
 
@@ -89,11 +156,77 @@ int main(int argc, char *argv[])
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
 
-    if (argc != 2) {
-        std::cerr << "Usage: pprank file" << std::endl;
+    const std::string usage = "Usage: pprank [-r degree|hub|rcm|gorder] [-t threads] "
+                              "[-p float|double|mixed|escalating] [-x period] [-m power|gmres|bicgstab] [-g restart] "
+                              "file";
+
+    const std::vector<std::string> methods = {"power", "gmres", "bicgstab"};
+
+    std::string strategy, precision, method = "power";
+    uint_fast32_t num_threads = 1, extrapolation_period = 0, restart = 10;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:p:x:m:g:")) != -1) {
+        switch (opt) {
+            case 'r':
+                strategy = optarg;
+                if (std::find(reorder_strategies.begin(), reorder_strategies.end(), strategy) ==
+                        reorder_strategies.end()) {
+                    if (rank == MASTER) { std::cerr << usage << std::endl; }
+                    MPI_Finalize();
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 't':
+                num_threads = std::strtoul(optarg, nullptr, 10);
+                if (num_threads == 0) {
+                    if (rank == MASTER) { std::cerr << usage << std::endl; }
+                    MPI_Finalize();
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                precision = optarg;
+                if (std::find(precisions.begin(), precisions.end(), precision) == precisions.end()) {
+                    if (rank == MASTER) { std::cerr << usage << std::endl; }
+                    MPI_Finalize();
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'x':
+                extrapolation_period = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'm':
+                method = optarg;
+                if (std::find(methods.begin(), methods.end(), method) == methods.end()) {
+                    if (rank == MASTER) { std::cerr << usage << std::endl; }
+                    MPI_Finalize();
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'g':
+                restart = std::strtoul(optarg, nullptr, 10);
+                if (restart == 0) {
+                    if (rank == MASTER) { std::cerr << usage << std::endl; }
+                    MPI_Finalize();
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                if (rank == MASTER) { std::cerr << usage << std::endl; }
+                MPI_Finalize();
+                return EXIT_FAILURE;
+        }
+    }
+    // note that the Krylov solvers are not extrapolated
+    if (optind != argc-1 or (method != "power" and extrapolation_period > 0)) {
+        if (rank == MASTER) { std::cerr << usage << std::endl; }
+        MPI_Finalize();
         return EXIT_FAILURE;
     }
-    const char* filename = argv[1];
+    const char* filename = argv[optind];
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#endif
 
     hrc::time_point start_time, end_time;
     std::chrono::duration<pprank_t> duration;
@@ -104,8 +237,9 @@ int main(int argc, char *argv[])
         start_time = hrc::now();
     }
 
-    const TCSR tcsr = TCSR(filename);
+    TCSR tcsr = TCSR(filename);
     assert(tcsr.num_rows == tcsr.num_cols);
+    const uint_fast32_t num_nodes = tcsr.num_rows, num_edges = tcsr.a.size();
 
     if (rank == MASTER) {
         end_time = hrc::now();
@@ -118,7 +252,57 @@ int main(int argc, char *argv[])
     }
     ////////////////////////////////////////////////////////////////////////////
 
-    const pprank_t tol = 1e-6;
+    // relabel the nodes to improve the locality of the matrix-vector products
+    // every node computes the same (deterministic) permutation, so nothing needs to be exchanged
+    std::vector<uint_fast32_t> perm;
+    if (not strategy.empty()) {
+        if (rank == MASTER) {
+            std::cout << "[*] Reordering the nodes (" << strategy << ")..." << std::flush;
+            start_time = hrc::now();
+        }
+
+        perm = reorder(tcsr, strategy);
+        TCSR reordered = tcsr.permute(perm);
+
+        if (rank == MASTER) {
+            end_time = hrc::now();
+            duration = end_time-start_time;
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << "[" << duration.count() << " s]" << std::endl;
+
+            const double before = time_tdot(tcsr), after = time_tdot(reordered);
+            std::cout << std::setprecision(4);
+            std::cout << "        SpMV time:  " << before << " s -> " << after << " s";
+            std::cout << std::setprecision(2) << " (" << before/after << "x)" << std::endl;
+        }
+
+        tcsr = std::move(reordered);
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    // convert the matrix to the requested precision, freeing the default one since it is not needed anymore
+    BasicTCSR<float> tcsr_float;
+    BasicTCSR<double> tcsr_double;
+    if (not precision.empty()) {
+        if (rank == MASTER) {
+            std::cout << "[*] Converting the sparse transition matrix (" << precision << ")..." << std::flush;
+            start_time = hrc::now();
+        }
+
+        if (precision == "double" or precision == "escalating") { tcsr_double = BasicTCSR<double>(tcsr); }
+        else { tcsr_float = BasicTCSR<float>(tcsr); }
+        tcsr = TCSR();
+
+        if (rank == MASTER) {
+            end_time = hrc::now();
+            duration = end_time-start_time;
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << "[" << duration.count() << " s]" << std::endl;
+        }
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    const double tol = 1e-6;
 
     // compute PageRanks
     if (rank == MASTER) {
@@ -127,18 +311,55 @@ int main(int argc, char *argv[])
         start_time = hrc::now();
     }
 
-    uint_fast32_t iterations;
+    uint_fast32_t iterations, extrapolations;
+    bool converged;
     double work_time, netw_time;
-    pprank_vec_t ranks;
-    std::tie(iterations, work_time, netw_time, ranks) = pagerank(tcsr, tol);
+    arma::vec ranks;
+    if (precision == "float") {
+        std::tie(iterations, extrapolations, converged, work_time, netw_time, ranks) =
+            pagerank<float, float>(tcsr_float, tol, num_threads, method, restart, extrapolation_period);
+    }
+    else if (precision == "double") {
+        std::tie(iterations, extrapolations, converged, work_time, netw_time, ranks) =
+            pagerank<double, double>(tcsr_double, tol, num_threads, method, restart, extrapolation_period);
+    }
+    else if (precision == "mixed") {
+        std::tie(iterations, extrapolations, converged, work_time, netw_time, ranks) =
+            pagerank<float, double>(tcsr_float, tol, num_threads, method, restart, extrapolation_period);
+    }
+    else if (precision == "escalating") {
+        // single precision ranks until the residual is small, then double precision ones starting from them
+        uint_fast32_t float_iterations, float_extrapolations;
+        double float_work_time, float_netw_time;
+        std::tie(float_iterations, float_extrapolations, std::ignore, float_work_time, float_netw_time, ranks) =
+            pagerank<double, float>(tcsr_double, escalation_tol, num_threads, method, restart, extrapolation_period);
+        std::tie(iterations, extrapolations, converged, work_time, netw_time, ranks) =
+            pagerank<double, double>(tcsr_double, tol, num_threads, method, restart, extrapolation_period, ranks);
+        iterations += float_iterations;
+        extrapolations += float_extrapolations;
+        work_time += float_work_time;
+        netw_time += float_netw_time;
+    }
+    else {
+        std::tie(iterations, extrapolations, converged, work_time, netw_time, ranks) =
+            pagerank<pprank_t, pprank_t>(tcsr, tol, num_threads, method, restart, extrapolation_period);
+    }
+    if (not perm.empty()) { ranks = unpermute(ranks, perm); }
 
     if (rank == MASTER) {
         end_time = hrc::now();
         duration = end_time-start_time;
         std::cout << std::fixed << std::setprecision(2);
         std::cout << "[" << iterations << " iterations / " << duration.count() << " s]" << std::endl;
+        std::cout << "        (MASTER) Threads:   " << num_threads << std::endl;
         std::cout << "        (MASTER) Work time: " << work_time << " s" << std::endl;
         std::cout << "        (MASTER) Netw time: " << netw_time << " s" << std::endl;
+        if (extrapolation_period > 0) {
+            std::cout << "        (MASTER) Extrapolations: " << extrapolations << std::endl;
+        }
+        if (not converged) {
+            std::cout << "        (MASTER) [!] tol not reached: the residual stopped decreasing" << std::endl;
+        }
     }
     ////////////////////////////////////////////////////////////////////////////
 
@@ -147,7 +368,7 @@ int main(int argc, char *argv[])
         std::cout << "[*] Writing PageRanks to file..." << std::flush;
         start_time = hrc::now();
 
-        std::ofstream outfile("PageRanks-" + std::to_string(tcsr.num_rows) + "-" + std::to_string(tcsr.a.size()) + ".txt");
+        std::ofstream outfile("PageRanks-" + std::to_string(num_nodes) + "-" + std::to_string(num_edges) + ".txt");
         outfile << std::fixed << std::scientific;
         for (uint_fast32_t node = 0; node < ranks.size(); ++node) {
             outfile << std::setfill('0') << std::setw(9) << node << ": " << ranks[node] << std::endl;
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "prefetch.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+const std::vector<uint_fast32_t> prefetch_distances = {4, 8, 16, 32, 64, 128, 256};
+
+
+uint_fast32_t calibrate_distance(const TCSR& tcsr)
+{
+    // choose the prefetch distance with the fastest matrix-vector product on the given matrix
+    uint_fast32_t best_distance = prefetch_distances.front();
+    double best_time = 0.0;
+    for (const uint_fast32_t distance : prefetch_distances) {
+        const double time = time_tdot(PrefetchTCSR(tcsr, distance), 3);
+        if (best_time == 0.0 or time < best_time) {
+            best_distance = distance;
+            best_time = time;
+        }
+    }
+    return best_distance;
+}
+
+
+PrefetchTCSR::PrefetchTCSR(const TCSR& tcsr, uint_fast32_t distance) :
+    tcsr(tcsr), num_rows(tcsr.num_rows), num_cols(tcsr.num_cols),
+    distance(distance > 0 ? distance : calibrate_distance(tcsr))
+{
+}
+
+pprank_vec_t PrefetchTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void PrefetchTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    res.zeros();
+    if (tcsr.ja.empty()) { return; }
+
+    pprank_t* res_ptr = res.memptr();
+    const uint_fast32_t* ja = tcsr.ja.data();
+    const uint_fast32_t last = tcsr.ja.size()-1;
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        const pprank_t vec_i = vec[i];
+        for (uint_fast32_t k = tcsr.ia[i]; k < tcsr.ia[i+1]; ++k) {
+            // the prefetches cross the boundaries between rows, and stop at the last nonzero value
+            __builtin_prefetch(res_ptr+ja[std::min(k+distance, last)], 1);
+            res_ptr[ja[k]] += tcsr.a[k] * vec_i;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "propagation.hpp"
+#include "segmented.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+PropagationTCSR::PropagationTCSR(const TCSR& tcsr, uint_fast32_t bin_width) :
+    tcsr(tcsr), num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), bin_bits(0)
+{
+    // the width of the bins is rounded down to a power of two, so that the bin of a column is just a shift away
+    if (bin_width == 0) { bin_width = default_segment_size(); }
+    while ((UINT64_C(2) << bin_bits) <= bin_width) {
+        ++bin_bits;
+    }
+
+    // count the entries of each bin
+    const uint_fast32_t num_bins = (num_cols >> bin_bits)+1;
+    bin_ia.assign(num_bins+1, 0);
+    for (uint_fast32_t k = 0; k < tcsr.ja.size(); ++k) {
+        ++bin_ia[(tcsr.ja[k] >> bin_bits)+1];
+    }
+    for (uint_fast32_t b = 0; b < num_bins; ++b) {
+        bin_ia[b+1] += bin_ia[b];
+    }
+
+    // store the destinations of the entries of each bin, in the same order in which tdot() appends them
+    bin_ja.resize(tcsr.ja.size());
+    bin_values.resize(tcsr.ja.size());
+    bin_next.resize(num_bins);
+    std::vector<uint_fast32_t> next(bin_ia.begin(), bin_ia.end()-1);
+    for (uint_fast32_t k = 0; k < tcsr.ja.size(); ++k) {
+        bin_ja[next[tcsr.ja[k] >> bin_bits]++] = tcsr.ja[k];
+    }
+}
+
+pprank_vec_t PropagationTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void PropagationTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    // first, the contributions are appended to the bins: each bin is written sequentially
+    assert(res.n_elem == num_cols);
+    std::copy(bin_ia.begin(), bin_ia.end()-1, bin_next.begin());
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        const pprank_t vec_i = vec[i];
+        for (uint_fast32_t k = tcsr.ia[i]; k < tcsr.ia[i+1]; ++k) {
+            bin_values[bin_next[tcsr.ja[k] >> bin_bits]++] = tcsr.a[k] * vec_i;
+        }
+    }
+
+    // then, the bins are accumulated: all the writes of a bin fall in a range of 2^bin_bits entries of the result
+    res.zeros();
+    for (uint_fast32_t e = 0; e < bin_ja.size(); ++e) {
+        res[bin_ja[e]] += bin_values[e];
+    }
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "reorder.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+const std::vector<std::string> reorder_strategies = {"degree", "hub", "rcm", "gorder"};
+
+
+inline std::vector<uint_fast32_t> in_degrees(const TCSR& A)
+{
+    std::vector<uint_fast32_t> degrees(A.num_cols, 0);
+    for (uint_fast32_t k = 0; k < A.ja.size(); ++k) {
+        ++degrees[A.ja[k]];
+    }
+    return degrees;
+}
+
+inline std::vector<uint_fast32_t> order_to_perm(const std::vector<uint_fast32_t>& order)
+{
+    // convert a list of nodes (in their new order) to a permutation
+    std::vector<uint_fast32_t> perm(order.size());
+    for (uint_fast32_t pos = 0; pos < order.size(); ++pos) {
+        perm[order[pos]] = pos;
+    }
+    return perm;
+}
+
+
+std::vector<uint_fast32_t> degree_order(const TCSR& A)
+{
+    // sort the nodes by decreasing in-degree, so that the most written entries of the result of tdot() are packed
+    // together at the beginning of the vector
+    assert(A.num_rows == A.num_cols);
+    const std::vector<uint_fast32_t> degrees = in_degrees(A);
+
+    std::vector<uint_fast32_t> order(A.num_rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint_fast32_t u, uint_fast32_t v) {
+        return degrees[u] > degrees[v];
+    });
+    return order_to_perm(order);
+}
+
+std::vector<uint_fast32_t> hub_order(const TCSR& A)
+{
+    // move the hubs (the nodes with in-degree above the average) to the beginning, without sorting them
+    // unlike degree_order(), the relative order of all the other nodes is preserved
+    assert(A.num_rows == A.num_cols);
+    const std::vector<uint_fast32_t> degrees = in_degrees(A);
+    const double avg_degree = ((double) A.ja.size())/A.num_rows;
+
+    std::vector<uint_fast32_t> order(A.num_rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_partition(order.begin(), order.end(), [&](uint_fast32_t u) {
+        return degrees[u] > avg_degree;
+    });
+    return order_to_perm(order);
+}
+
+std::vector<uint_fast32_t> rcm_order(const TCSR& A)
+{
+    // reverse Cuthill-McKee on the symmetrized graph: a breadth-first visit starting from a node of minimum degree,
+    // enqueuing the neighbors of each node by increasing degree
+    assert(A.num_rows == A.num_cols);
+    const uint_fast32_t N = A.num_rows;
+    const TCSR At = A.transpose();
+
+    // build the adjacency lists of the undirected graph (out-edges and in-edges, without duplicates)
+    std::vector<uint_fast32_t> adj_ia(1, 0), adj_ja;
+    adj_ja.reserve(A.ja.size()+At.ja.size());
+    for (uint_fast32_t i = 0; i < N; ++i) {
+        const auto begin = adj_ja.end()-adj_ja.begin();
+        adj_ja.insert(adj_ja.end(), A.ja.begin()+A.ia[i], A.ja.begin()+A.ia[i+1]);
+        adj_ja.insert(adj_ja.end(), At.ja.begin()+At.ia[i], At.ja.begin()+At.ia[i+1]);
+        std::sort(adj_ja.begin()+begin, adj_ja.end());
+        adj_ja.erase(std::unique(adj_ja.begin()+begin, adj_ja.end()), adj_ja.end());
+        adj_ia.push_back(adj_ja.size());
+    }
+    const auto degree = [&](uint_fast32_t u) { return adj_ia[u+1]-adj_ia[u]; };
+
+    // the starting node of each connected component is the unvisited node of minimum degree
+    std::vector<uint_fast32_t> by_degree(N);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](uint_fast32_t u, uint_fast32_t v) {
+        return degree(u) < degree(v);
+    });
+
+    std::vector<bool> visited(N, false);
+    std::vector<uint_fast32_t> order;
+    order.reserve(N);
+    for (const uint_fast32_t start : by_degree) {
+        if (visited[start]) { continue; }
+
+        // the order vector itself is used as the queue of the visit
+        visited[start] = true;
+        order.push_back(start);
+        for (uint_fast32_t head = order.size()-1; head < order.size(); ++head) {
+            const uint_fast32_t u = order[head];
+            const auto first_new = order.end()-order.begin();
+            for (uint_fast32_t k = adj_ia[u]; k < adj_ia[u+1]; ++k) {
+                const uint_fast32_t v = adj_ja[k];
+                if (visited[v]) { continue; }
+                visited[v] = true;
+                order.push_back(v);
+            }
+            std::stable_sort(order.begin()+first_new, order.end(), [&](uint_fast32_t v, uint_fast32_t w) {
+                return degree(v) < degree(w);
+            });
+        }
+    }
+    assert(order.size() == N);
+
+    std::reverse(order.begin(), order.end());
+    return order_to_perm(order);
+}
+
+
+namespace
+{
+    // max-priority queue of nodes with small integer keys, supporting increments and decrements by one in O(1)
+    // nodes are kept in doubly linked lists, one for each key value (see the Gorder paper by Wei et al.)
+    class UnitHeap {
+        public:
+            UnitHeap(uint_fast32_t n) : key(n, 0), prev(n), next(n), removed(n, false), head(1, NIL), top(0)
+            {
+                for (uint_fast32_t u = n; u-- > 0;) {
+                    link(u);
+                }
+            }
+
+            void increment(uint_fast32_t u)
+            {
+                if (removed[u]) { return; }
+                unlink(u);
+                if (++key[u] == head.size()) { head.push_back(NIL); }
+                link(u);
+                top = std::max(top, key[u]);
+            }
+
+            void decrement(uint_fast32_t u)
+            {
+                if (removed[u] or key[u] == 0) { return; }
+                unlink(u);
+                --key[u];
+                link(u);
+            }
+
+            void remove(uint_fast32_t u)
+            {
+                assert(not removed[u]);
+                unlink(u);
+                removed[u] = true;
+            }
+
+            uint_fast32_t pop()
+            {
+                // extract the node with the largest key
+                while (head[top] == NIL) {
+                    assert(top > 0);
+                    --top;
+                }
+                const uint_fast32_t u = head[top];
+                remove(u);
+                return u;
+            }
+
+        private:
+            static const uint_fast32_t NIL = UINT_FAST32_MAX;
+
+            std::vector<uint_fast32_t> key, prev, next;
+            std::vector<bool> removed;
+            std::vector<uint_fast32_t> head;
+            uint_fast32_t top;
+
+            void link(uint_fast32_t u)
+            {
+                prev[u] = NIL;
+                next[u] = head[key[u]];
+                if (next[u] != NIL) { prev[next[u]] = u; }
+                head[key[u]] = u;
+            }
+
+            void unlink(uint_fast32_t u)
+            {
+                if (prev[u] != NIL) { next[prev[u]] = next[u]; }
+                else { head[key[u]] = next[u]; }
+                if (next[u] != NIL) { prev[next[u]] = prev[u]; }
+            }
+    };
+
+    const uint_fast32_t UnitHeap::NIL;
+}
+
+std::vector<uint_fast32_t> gorder_order(const TCSR& A, uint_fast32_t window)
+{
+    // Gorder (Wei et al., 2016): greedily append the node sharing the most neighbors and siblings (i.e. in-neighbors)
+    // with the last `window` placed nodes, so that nodes accessed close in time are also close in memory
+    assert(A.num_rows == A.num_cols and window > 0);
+    const uint_fast32_t N = A.num_rows;
+    if (N == 0) { return {}; }
+    const TCSR At = A.transpose();
+
+    // in-neighbors with a huge out-degree are skipped when looking for siblings, otherwise each placement would
+    // touch a large fraction of the graph
+    const uint_fast32_t max_sibling_degree = std::max<uint_fast32_t>(std::sqrt(N), 16);
+
+    UnitHeap heap(N);
+    const auto update = [&](uint_fast32_t v, bool entering) {
+        const auto apply = [&](uint_fast32_t u) {
+            if (entering) { heap.increment(u); }
+            else { heap.decrement(u); }
+        };
+        for (uint_fast32_t k = A.ia[v]; k < A.ia[v+1]; ++k) {
+            apply(A.ja[k]);
+        }
+        for (uint_fast32_t k = At.ia[v]; k < At.ia[v+1]; ++k) {
+            const uint_fast32_t w = At.ja[k];
+            apply(w);
+            if (A.ia[w+1]-A.ia[w] > max_sibling_degree) { continue; }
+            for (uint_fast32_t l = A.ia[w]; l < A.ia[w+1]; ++l) {
+                if (A.ja[l] != v) { apply(A.ja[l]); }
+            }
+        }
+    };
+
+    // start from the node with the largest in-degree
+    const std::vector<uint_fast32_t> degrees = in_degrees(A);
+    const uint_fast32_t first = std::max_element(degrees.begin(), degrees.end())-degrees.begin();
+
+    std::vector<uint_fast32_t> order;
+    order.reserve(N);
+    heap.remove(first);
+    order.push_back(first);
+    update(first, true);
+    while (order.size() < N) {
+        const uint_fast32_t v = heap.pop();
+        order.push_back(v);
+        update(v, true);
+
+        // the oldest node leaves the window
+        if (order.size() > window) { update(order[order.size()-1-window], false); }
+    }
+    return order_to_perm(order);
+}
+
+
+std::vector<uint_fast32_t> reorder(const TCSR& A, const std::string& strategy)
+{
+    if (strategy == "degree") { return degree_order(A); }
+    if (strategy == "hub") { return hub_order(A); }
+    if (strategy == "rcm") { return rcm_order(A); }
+    if (strategy == "gorder") { return gorder_order(A); }
+
+    std::cerr << "[!] Unknown reordering strategy: " << strategy << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+template<typename T>
+arma::Col<T> unpermute(const arma::Col<T>& vec, const std::vector<uint_fast32_t>& perm)
+{
+    // bring a vector computed on the relabeled graph back to the original node ids
+    assert(vec.size() == perm.size());
+    arma::Col<T> res(vec.size());
+    for (uint_fast32_t i = 0; i < perm.size(); ++i) {
+        res[i] = vec[perm[i]];
+    }
+    return res;
+}
+
+template arma::Col<float> unpermute(const arma::Col<float>&, const std::vector<uint_fast32_t>&);
+template arma::Col<double> unpermute(const arma::Col<double>&, const std::vector<uint_fast32_t>&);
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "segmented.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+uint_fast32_t default_segment_size()
+{
+    // half of the cache is reserved for the entries of the result written by a segment, while the other half is left
+    // for the values streamed from the matrix and the input vector
+    return std::max<uint_fast32_t>(cache_size()/2/sizeof(pprank_t), 1024);
+}
+
+
+SegmentedTCSR::SegmentedTCSR(const TCSR& tcsr, uint_fast32_t segment_size) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols),
+    segment_size(segment_size > 0 ? segment_size : default_segment_size())
+{
+    // split a matrix by columns into segments
+    const uint_fast32_t num_segments = (num_cols+this->segment_size-1)/this->segment_size;
+    segments.resize(std::max<uint_fast32_t>(num_segments, 1));
+
+    // count the nonzero values of each segment, to allocate the memory only once
+    std::vector<uint_fast32_t> nnz(segments.size(), 0);
+    for (uint_fast32_t k = 0; k < tcsr.ja.size(); ++k) {
+        ++nnz[tcsr.ja[k]/this->segment_size];
+    }
+    for (uint_fast32_t s = 0; s < segments.size(); ++s) {
+        segments[s].a.reserve(nnz[s]);
+        segments[s].ja.reserve(nnz[s]);
+        segments[s].ia.push_back(0);
+    }
+
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        for (uint_fast32_t k = tcsr.ia[i]; k < tcsr.ia[i+1]; ++k) {
+            Segment& segment = segments[tcsr.ja[k]/this->segment_size];
+            // the first nonzero value of row i in this segment starts a new row
+            if (segment.rows.empty() or segment.rows.back() != i) {
+                segment.rows.push_back(i);
+                segment.ia.push_back(segment.ia.back());
+            }
+            segment.a.push_back(tcsr.a[k]);
+            segment.ja.push_back(tcsr.ja[k]);
+            ++segment.ia.back();
+        }
+    }
+}
+
+pprank_vec_t SegmentedTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void SegmentedTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller, one segment at a time
+    // all the writes of a segment fall in a range of segment_size entries of the result, which stays in cache
+    assert(res.n_elem == num_cols);
+    res.zeros();
+    for (const Segment& segment : segments) {
+        for (uint_fast32_t r = 0; r < segment.rows.size(); ++r) {
+            const pprank_t vec_i = vec[segment.rows[r]];
+            for (uint_fast32_t k = segment.ia[r]; k < segment.ia[r+1]; ++k) {
+                res[segment.ja[k]] += segment.a[k] * vec_i;
+            }
+        }
+    }
+}
@@ -1,13 +1,41 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <string>
 #include <tuple>
+#include <vector>
 
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "autotune.hpp"
+#include "binned.hpp"
+#include "csr5.hpp"
+#include "hybrid.hpp"
+#include "mergepath.hpp"
+#include "packed.hpp"
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include "propagation.hpp"
+#include "reorder.hpp"
+#include "segmented.hpp"
+#include "simd.hpp"
+#include "solvers.hpp"
+#include "specialized.hpp"
+#include "stealing.hpp"
+#include "tiled.hpp"
 #include "utils.hpp"
 
 #include "armadillo"
@@ -15,42 +43,134 @@
 using hrc = std::chrono::high_resolution_clock;
 
 
-std::tuple<uint_fast32_t, pprank_vec_t> pagerank(const TCSR& A, const pprank_t tol)
+void print_tdot_times(double before, double after)
 {
-    assert(A.num_rows == A.num_cols);
-
-    // initialization
-    const uint_fast32_t N = A.num_rows;
-    const pprank_t d = 0.85;
-    const pprank_vec_t ones(N, arma::fill::ones);
-    const arma::uvec dangling_nodes = arma::conv_to<arma::uvec>::from(A.dangling_nodes);
-
-    pprank_vec_t p(N), p_new(N);
-    p_new.fill(1.0/N);
+    // compare the time of a matrix-vector product before and after a transformation of the matrix
+    std::cout << std::setprecision(4);
+    std::cout << "        SpMV time:  " << before << " s -> " << after << " s";
+    std::cout << std::setprecision(2) << " (" << before/after << "x)" << std::endl;
+}
 
-    // ranks computation
-    uint_fast32_t iterations = 0;
-    do {
-        ++iterations;
-        p = p_new;
 
-        pprank_vec_t At_dot_p = A.tdot(p);
-        At_dot_p += arma::sum(p(dangling_nodes))/N * ones;
+template<typename V, typename R>
+std::tuple<uint_fast32_t, bool, arma::vec> pagerank_threaded(const BasicTCSR<V>& A, const uint_fast32_t num_threads,
+        const double tol, const std::string& method, const uint_fast32_t restart,
+        const uint_fast32_t extrapolation_period, const arma::vec& p_init = arma::vec())
+{
+    // the power iteration (or a Krylov solver) with the threaded matrix-vector product, computing the ranks with
+    // type R (starting from p_init, if given), returning also whether the residual fell below tol
+    const BasicThreadedTCSR<V, R> threaded(A, num_threads);
+    const basic_tdot_fn<R> tdot = [&threaded](const arma::Col<R>& vec, arma::Col<R>& res) { threaded.tdot(vec, res); };
+    const arma::Col<R> x_init = arma::conv_to<arma::Col<R>>::from(p_init);
 
-        p_new = (1.0-d)/N * ones + d * At_dot_p;
-    }
-    while (arma::norm(p_new-p, 1) >= tol);
-    return std::make_tuple(iterations, p_new);
+    uint_fast32_t iterations;
+    bool converged = true;
+    arma::Col<R> ranks;
+    if (method == "gmres") { std::tie(iterations, converged, ranks) = pagerank_gmres(A, tdot, tol, restart, x_init); }
+    else if (method == "bicgstab") { std::tie(iterations, converged, ranks) = pagerank_bicgstab(A, tdot, tol, x_init); }
+    else { std::tie(iterations, ranks) = pagerank_power(A, tdot, tol, x_init, extrapolation_period); }
+    return std::make_tuple(iterations, converged, arma::conv_to<arma::vec>::from(ranks));
 }
 
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        std::cerr << "Usage: sequential file" << std::endl;
+    const std::string usage = "Usage: sequential [-r degree|hub|rcm|gorder] "
+                              "[-k csr|segmented|tiled|hybrid|packed|propagation|simd|prefetch|stealing|mergepath|"
+                              "specialized|binned|csr5|auto] "
+                              "[-s size] [-H threshold] [-D distance] [-t threads] "
+                              "[-m power|fused|pushpull|gaussseidel|adaptive|gmres|bicgstab] [-g restart] "
+                              "[-e threshold] [-x period] [-B count] [-p float|double|mixed|escalating] file";
+    const std::vector<std::string> methods = {"power", "fused", "pushpull", "gaussseidel", "adaptive", "gmres",
+                                              "bicgstab"};
+
+    std::string strategy, kernel = "csr", method = "power", precision;
+    uint_fast32_t segment_size = 0, hub_threshold = 0, distance = 0, num_threads = 1, batch_size = 0;
+    uint_fast32_t extrapolation_period = 0, restart = 10;
+    pprank_t push_threshold = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:k:s:H:D:t:m:g:e:x:B:p:")) != -1) {
+        switch (opt) {
+            case 'r':
+                strategy = optarg;
+                if (std::find(reorder_strategies.begin(), reorder_strategies.end(), strategy) ==
+                        reorder_strategies.end()) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'k':
+                kernel = optarg;
+                if (kernel != "auto" and std::find(kernels.begin(), kernels.end(), kernel) == kernels.end()) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                segment_size = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'H':
+                hub_threshold = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'D':
+                distance = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 't':
+                num_threads = std::strtoul(optarg, nullptr, 10);
+                if (num_threads == 0) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                method = optarg;
+                if (std::find(methods.begin(), methods.end(), method) == methods.end()) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'g':
+                restart = std::strtoul(optarg, nullptr, 10);
+                if (restart == 0) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'e':
+                push_threshold = std::strtod(optarg, nullptr);
+                break;
+            case 'x':
+                extrapolation_period = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'B':
+                batch_size = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'p':
+                precision = optarg;
+                if (std::find(precisions.begin(), precisions.end(), precision) == precisions.end()) {
+                    std::cerr << usage << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                std::cerr << usage << std::endl;
+                return EXIT_FAILURE;
+        }
+    }
+    // note that the precisions selected at runtime are supported by the csr kernel with the power iteration and
+    // the Krylov solvers, while the other kernels and methods (and the batched solver) only support the precision
+    // chosen at compile time
+    const bool runtime_precision_method = method == "power" or method == "gmres" or method == "bicgstab";
+    if (optind != argc-1 or (kernel == "tiled" and segment_size > 65536) or
+            (not precision.empty() and (kernel != "csr" or not runtime_precision_method or batch_size > 0)) or
+            (extrapolation_period > 0 and method != "power")) {
+        std::cerr << usage << std::endl;
         return EXIT_FAILURE;
     }
-    const char* filename = argv[1];
+    const char* filename = argv[optind];
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#endif
 
     hrc::time_point start_time, end_time;
     std::chrono::duration<pprank_t> duration;
@@ -59,8 +179,9 @@ int main(int argc, char *argv[])
     std::cout << "[*] Building the sparse transition matrix..." << std::flush;
     start_time = hrc::now();
 
-    const TCSR tcsr = TCSR(filename);
+    TCSR tcsr = TCSR(filename);
     assert(tcsr.num_rows == tcsr.num_cols);
+    const uint_fast32_t num_nodes = tcsr.num_rows, num_edges = tcsr.a.size();
 
     end_time = hrc::now();
     duration = end_time-start_time;
@@ -71,28 +192,482 @@ int main(int argc, char *argv[])
     std::cout << "        Dangling:   " << tcsr.dangling_nodes.size() << std::endl;
     ////////////////////////////////////////////////////////////////////////////
 
-    const pprank_t tol = 1e-6;
+    // relabel the nodes to improve the locality of the matrix-vector products
+    std::vector<uint_fast32_t> perm;
+    if (not strategy.empty()) {
+        std::cout << "[*] Reordering the nodes (" << strategy << ")..." << std::flush;
+        start_time = hrc::now();
+
+        perm = reorder(tcsr, strategy);
+        TCSR reordered = tcsr.permute(perm);
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(reordered));
+
+        tcsr = std::move(reordered);
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    // build the storage format used by the matrix-vector products
+    tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+    if (kernel == "auto") {
+        std::cout << "[*] Autotuning the SpMV kernel..." << std::flush;
+        start_time = hrc::now();
+
+        // the fastest kernel is cached per graph, host and number of threads, so that only the first run pays for
+        // the autotuning
+        const std::string host = host_name(), fingerprint = graph_fingerprint(tcsr);
+        std::string best_kernel;
+        uint_fast32_t best_threads;
+        std::tie(best_kernel, best_threads) = load_tuning(tuning_file, host, fingerprint, num_threads);
+        std::vector<std::tuple<std::string, uint_fast32_t, double>> timings;
+        if (best_kernel.empty()) {
+            timings = autotune(tcsr, num_threads);
+            std::tie(best_kernel, best_threads, std::ignore) = timings.front();
+            save_tuning(tuning_file, host, fingerprint, num_threads, best_kernel, best_threads);
+        }
+        tdot = build_kernel(tcsr, best_kernel, best_threads);
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Graph:      " << fingerprint << " on " << host;
+        std::cout << (timings.empty() ? " (cached)" : "") << std::endl;
+        for (const auto& timing : timings) {
+            std::cout << "        Candidate:  " << std::setw(11) << std::left << std::get<0>(timing) << std::right;
+            std::cout << std::setw(3) << std::get<1>(timing) << " threads" << std::setprecision(4);
+            std::cout << " -> " << std::get<2>(timing) << " s" << std::setprecision(2) << std::endl;
+        }
+        std::cout << "        Kernel:     " << best_kernel << " (" << best_threads << " threads)" << std::endl;
+    }
+    else if (kernel == "csr" and num_threads > 1) {
+        std::cout << "[*] Measuring the scaling of the threaded SpMV..." << std::flush;
+        start_time = hrc::now();
+
+        std::vector<uint_fast32_t> counts;
+        std::vector<double> times;
+        for (uint_fast32_t n = 1; n < num_threads; n *= 2) {
+            counts.push_back(n);
+            times.push_back(time_tdot(ThreadedTCSR(tcsr, n)));
+        }
+        const auto threaded = std::make_shared<const ThreadedTCSR>(tcsr, num_threads);
+        tdot = [threaded](const pprank_vec_t& vec, pprank_vec_t& res) { threaded->tdot(vec, res); };
+        counts.push_back(num_threads);
+        times.push_back(time_tdot(*threaded));
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        for (uint_fast32_t r = 0; r < counts.size(); ++r) {
+            std::cout << "        Threads:    " << std::setw(3) << counts[r] << std::setprecision(4);
+            std::cout << " -> " << times[r] << " s" << std::setprecision(2) << " (" << times[0]/times[r] << "x)";
+            std::cout << std::endl;
+        }
+    }
+    else if (kernel == "segmented") {
+        std::cout << "[*] Building the segmented matrix..." << std::flush;
+        start_time = hrc::now();
+
+        const auto scsr = std::make_shared<const SegmentedTCSR>(tcsr, segment_size);
+        tdot = [scsr](const pprank_vec_t& vec, pprank_vec_t& res) { scsr->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Segments:   " << scsr->segments.size() << std::endl;
+        std::cout << "        Columns:    " << scsr->segment_size << " per segment" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*scsr));
+    }
+    else if (kernel == "tiled") {
+        std::cout << "[*] Building the tiled matrix..." << std::flush;
+        start_time = hrc::now();
+
+        const auto tiled = std::make_shared<const TiledTCSR>(tcsr, segment_size);
+        tdot = [tiled](const pprank_vec_t& vec, pprank_vec_t& res) { tiled->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Tiles:      " << tiled->tiles.size() << std::endl;
+        std::cout << "        Columns:    " << tiled->tile_size << " per tile" << std::endl;
+
+        const double before = (tcsr.ia.size()+tcsr.ja.size())*sizeof(uint_fast32_t)/1e6;
+        const double after = tiled->index_bytes()/1e6;
+        std::cout << "        Indices:    " << before << " MB -> " << after << " MB";
+        std::cout << " (" << before/after << "x)" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*tiled));
+    }
+    else if (kernel == "hybrid") {
+        std::cout << "[*] Building the hybrid matrix..." << std::flush;
+        start_time = hrc::now();
+
+        const auto hybrid = std::make_shared<const HybridTCSR>(tcsr, hub_threshold, segment_size);
+        tdot = [hybrid](const pprank_vec_t& vec, pprank_vec_t& res) { hybrid->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Hubs:       " << hybrid->hubs.size() << " (over " << hybrid->hub_threshold << " edges)";
+        std::cout << std::endl;
+        std::cout << "        Hub edges:  " << hybrid->hub_a.size() << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*hybrid));
+    }
+    else if (kernel == "packed") {
+        std::cout << "[*] Building the bit-packed matrix..." << std::flush;
+        start_time = hrc::now();
+
+        const auto packed = std::make_shared<const PackedTCSR>(tcsr);
+        tdot = [packed](const pprank_vec_t& vec, pprank_vec_t& res) { packed->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+
+        const double before = tcsr.ja.size()*sizeof(uint_fast32_t)/1e6;
+        const double after = packed->packed_ja.size()*sizeof(uint64_t)/1e6;
+        std::cout << "        Bits:       " << packed->bits << " per column index" << std::endl;
+        std::cout << "        Indices:    " << before << " MB -> " << after << " MB";
+        std::cout << " (" << before/after << "x)" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*packed));
+    }
+    else if (kernel == "propagation") {
+        std::cout << "[*] Building the bins for propagation blocking..." << std::flush;
+        start_time = hrc::now();
+
+        const auto propagation = std::make_shared<const PropagationTCSR>(tcsr, segment_size);
+        tdot = [propagation](const pprank_vec_t& vec, pprank_vec_t& res) { propagation->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Bins:       " << propagation->bin_ia.size()-1 << std::endl;
+        std::cout << "        Columns:    " << (UINT64_C(1) << propagation->bin_bits) << " per bin" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*propagation));
+    }
+    else if (kernel == "simd") {
+        std::cout << "[*] Building the transposed matrix for the SIMD kernel..." << std::flush;
+        start_time = hrc::now();
+
+        const auto simd = std::make_shared<const SimdTCSR>(tcsr);
+        tdot = [simd](const pprank_vec_t& vec, pprank_vec_t& res) { simd->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        ISA:        " << simd->isa << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*simd));
+    }
+    else if (kernel == "prefetch") {
+        std::cout << "[*] Calibrating the prefetch distance..." << std::flush;
+        start_time = hrc::now();
+
+        const auto prefetch = std::make_shared<const PrefetchTCSR>(tcsr, distance);
+        tdot = [prefetch](const pprank_vec_t& vec, pprank_vec_t& res) { prefetch->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Distance:   " << prefetch->distance << " nonzero values" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*prefetch));
+    }
+    else if (kernel == "stealing") {
+        std::cout << "[*] Building the chunks of the work-stealing SpMV..." << std::flush;
+        start_time = hrc::now();
+
+        const auto stealing = std::make_shared<const StealingTCSR>(tcsr, num_threads);
+        tdot = [stealing](const pprank_vec_t& vec, pprank_vec_t& res) { stealing->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Chunks:     " << stealing->bounds.size()-1 << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*stealing));
+        for (uint_fast32_t t = 0; t < num_threads; ++t) {
+            std::cout << "        Thread " << std::setw(3) << t << ": " << std::setprecision(4);
+            std::cout << stealing->busy_time[t] << " s busy, " << stealing->idle_time[t] << " s idle, ";
+            std::cout << stealing->stolen[t] << " chunks stolen" << std::endl;
+        }
+        std::cout << std::setprecision(2);
+        stealing->reset_stats();
+    }
+    else if (kernel == "mergepath") {
+        std::cout << "[*] Splitting the merge path of the SpMV..." << std::flush;
+        start_time = hrc::now();
+
+        const auto mergepath = std::make_shared<const MergePathTCSR>(tcsr, num_threads);
+        tdot = [mergepath](const pprank_vec_t& vec, pprank_vec_t& res) { mergepath->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Work:       " << (((uint_fast64_t) tcsr.num_cols)+tcsr.a.size())/mergepath->num_threads;
+        std::cout << " rows and nonzero values per thread" << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), time_tdot(*mergepath));
+    }
+    else if (kernel == "binned") {
+        std::cout << "[*] Binning the rows of the transposed matrix by degree..." << std::flush;
+        start_time = hrc::now();
+
+        const auto binned = std::make_shared<const BinnedTCSR>(tcsr, hub_threshold);
+        tdot = [binned](const pprank_vec_t& vec, pprank_vec_t& res) { binned->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        uint_fast64_t num_tiny = 0;
+        for (const auto& bin : binned->tiny_bins) { num_tiny += bin.rows.size(); }
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Tiny:       " << num_tiny << " rows (up to " << binned->tiny_degree << " edges)";
+        std::cout << std::endl;
+        std::cout << "        Medium:     " << binned->medium_bin.rows.size() << " rows" << std::endl;
+        std::cout << "        Huge:       " << binned->huge_bin.rows.size() << " rows (over " << binned->huge_threshold;
+        std::cout << " edges, " << binned->segment_rows.size() << " segments)" << std::endl;
+
+        const double before = time_tdot(tcsr);
+        binned->reset_stats();
+        const double after = time_tdot(*binned);
+        print_tdot_times(before, after);
+        const double total = std::accumulate(binned->bin_time.begin(), binned->bin_time.end(), 0.0);
+        for (uint_fast32_t b = 0; b < bin_names.size(); ++b) {
+            std::cout << "        Bin:        " << std::setw(7) << std::left << bin_names[b] << std::right;
+            std::cout << std::setprecision(4) << binned->bin_time[b] << " s" << std::setprecision(2);
+            std::cout << " (" << 100*binned->bin_time[b]/total << "%)" << std::endl;
+        }
+        binned->reset_stats();
+    }
+    else if (kernel == "csr5") {
+        std::cout << "[*] Building the CSR5 tiles..." << std::flush;
+        start_time = hrc::now();
+
+        const auto csr5 = std::make_shared<const Csr5TCSR>(tcsr);
+        tdot = [csr5](const pprank_vec_t& vec, pprank_vec_t& res) { csr5->tdot(vec, res); };
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        uint_fast32_t num_dirty = 0;
+        for (uint_fast32_t t = 0; t < csr5->tile_ptr.size(); ++t) {
+            if (csr5->empty_ptr[t] < csr5->empty_ptr[t+1]) { ++num_dirty; }
+        }
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        std::cout << "        Tiles:      " << csr5->tile_ptr.size() << " (" << csr5->omega << " x " << csr5->sigma;
+        std::cout << " nonzero values)" << std::endl;
+        std::cout << "        Dirty:      " << num_dirty << " tiles spanning empty rows" << std::endl;
+
+        // the conversion pays off after enough products, i.e. after enough iterations of the power method
+        const double before = time_tdot(tcsr), after = time_tdot(*csr5);
+        print_tdot_times(before, after);
+        if (after < before) {
+            std::cout << "        Break-even: " << (uint_fast64_t) std::ceil(duration.count()/(before-after));
+            std::cout << " products" << std::endl;
+        }
+    }
+    else if (kernel == "specialized") {
+        std::cout << "[*] Timing the specialized kernels..." << std::flush;
+        start_time = hrc::now();
+
+        const std::vector<double> times = calibrate_specializations(tcsr);
+        const uint_fast32_t best = std::min_element(times.begin(), times.end())-times.begin();
+        tdot = specializations[best].build(tcsr);
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+        for (uint_fast32_t s = 0; s < specializations.size(); ++s) {
+            if (std::isinf(times[s])) { continue; }
+            std::cout << "        Variant:    " << std::setw(18) << std::left << specializations[s].name << std::right;
+            std::cout << std::setprecision(4) << times[s] << " s" << std::setprecision(2) << std::endl;
+        }
+        std::cout << "        Kernel:     " << specializations[best].name << std::endl;
+
+        print_tdot_times(time_tdot(tcsr), times[best]);
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    // convert the matrix to the requested precision, freeing the default one (and the kernel built from it) since
+    // they are not needed anymore
+    BasicTCSR<float> tcsr_float;
+    BasicTCSR<double> tcsr_double;
+    if (not precision.empty()) {
+        std::cout << "[*] Converting the sparse transition matrix (" << precision << ")..." << std::flush;
+        start_time = hrc::now();
+
+        if (precision == "double" or precision == "escalating") { tcsr_double = BasicTCSR<double>(tcsr); }
+        else { tcsr_float = BasicTCSR<float>(tcsr); }
+        tcsr = TCSR();
+        tdot = nullptr;
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << duration.count() << " s]" << std::endl;
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    const double tol = 1e-6;
 
     // compute PageRanks
     std::cout << std::fixed << std::scientific;
     std::cout << "[*] Computing PageRanks (tol=" << tol << ")..." << std::flush;
     start_time = hrc::now();
 
-    uint_fast32_t iterations;
-    pprank_vec_t ranks;
-    std::tie(iterations, ranks) = pagerank(tcsr, tol);
+    // the ranks with the precision selected at runtime, returning also the iterations in single precision (if
+    // escalating) and whether the residual fell below tol
+    using precision_result = std::tuple<uint_fast32_t, uint_fast32_t, bool, arma::vec>;
+    const auto pagerank_precision = [&](const uint_fast32_t period) -> precision_result {
+        uint_fast32_t iterations, float_iterations = 0;
+        bool converged;
+        arma::vec ranks;
+        if (precision == "float") {
+            std::tie(iterations, converged, ranks) =
+                pagerank_threaded<float, float>(tcsr_float, num_threads, tol, method, restart, period);
+        }
+        else if (precision == "double") {
+            std::tie(iterations, converged, ranks) =
+                pagerank_threaded<double, double>(tcsr_double, num_threads, tol, method, restart, period);
+        }
+        else if (precision == "mixed") {
+            std::tie(iterations, converged, ranks) =
+                pagerank_threaded<float, double>(tcsr_float, num_threads, tol, method, restart, period);
+        }
+        else {
+            // the first iterations only need a few correct digits, so the ranks are kept in single precision
+            // (halving the memory traffic of the random accesses) until the residual is small, and refined in
+            // double afterwards
+            std::tie(float_iterations, std::ignore, ranks) =
+                pagerank_threaded<double, float>(tcsr_double, num_threads, escalation_tol, method, restart, period);
+            std::tie(iterations, converged, ranks) =
+                pagerank_threaded<double, double>(tcsr_double, num_threads, tol, method, restart, period, ranks);
+            iterations += float_iterations;
+        }
+        return std::make_tuple(iterations, float_iterations, converged, ranks);
+    };
+
+    uint_fast32_t iterations, pulls = 0, float_iterations = 0;
+    uint_fast64_t edges = 0;
+    bool converged = true;
+    arma::vec ranks;
+    if (not precision.empty()) {
+        std::tie(iterations, float_iterations, converged, ranks) = pagerank_precision(extrapolation_period);
+    }
+    else {
+        pprank_vec_t p;
+        if (method == "pushpull") {
+            std::tie(iterations, pulls, edges, p) = pagerank_push_pull(tcsr, tol, push_threshold);
+        }
+        else if (method == "fused") {
+            std::tie(iterations, p) = pagerank_fused(tcsr, tol);
+        }
+        else if (method == "gaussseidel") {
+            std::tie(iterations, p) = pagerank_gauss_seidel(tcsr, tol, num_threads);
+        }
+        else if (method == "adaptive") {
+            std::tie(iterations, edges, p) = pagerank_adaptive(tcsr, tol, push_threshold);
+        }
+        else if (method == "gmres") {
+            std::tie(iterations, converged, p) = pagerank_gmres(tcsr, tdot, tol, restart);
+        }
+        else if (method == "bicgstab") {
+            std::tie(iterations, converged, p) = pagerank_bicgstab(tcsr, tdot, tol);
+        }
+        else {
+            std::tie(iterations, p) = pagerank_power(tcsr, tdot, tol, pprank_vec_t(), extrapolation_period);
+        }
+        ranks = arma::conv_to<arma::vec>::from(p);
+    }
+    if (not perm.empty()) { ranks = unpermute(ranks, perm); }
 
     end_time = hrc::now();
     duration = end_time-start_time;
     std::cout << std::fixed << std::setprecision(2);
     std::cout << "[" << iterations << " iterations - " << duration.count() << " s]" << std::endl;
+    if (method == "pushpull") {
+        std::cout << "        Pulls:      " << pulls << " of " << iterations << " iterations" << std::endl;
+    }
+    if (method == "pushpull" or method == "adaptive") {
+        std::cout << "        Edges:      " << edges << " traversed (" << ((double) edges)/num_edges;
+        std::cout << " passes over the graph)" << std::endl;
+    }
+    if (not converged) {
+        std::cout << "        [!] tol not reached: the residual stopped decreasing" << std::endl;
+    }
+    if (precision == "escalating") {
+        std::cout << "        Single:     " << float_iterations << " of " << iterations << " iterations" << std::endl;
+    }
+    if (extrapolation_period > 0) {
+        // compare with the iterations needed without extrapolation
+        const auto plain_start_time = hrc::now();
+        const uint_fast32_t plain_iterations =
+            precision.empty() ? std::get<0>(pagerank_power(tcsr, tdot, tol)) : std::get<0>(pagerank_precision(0));
+        const std::chrono::duration<double> plain_duration = hrc::now()-plain_start_time;
+        std::cout << "        Without:    " << plain_iterations << " iterations - " << plain_duration.count() << " s";
+        std::cout << std::endl;
+    }
+    ////////////////////////////////////////////////////////////////////////////
+
+    // compute personalized PageRanks for a few seed nodes, all at once
+    // note that these are only timed, not written to file
+    if (batch_size > 0) {
+        std::cout << std::fixed << std::scientific;
+        std::cout << "[*] Computing " << batch_size << " personalized PageRanks (tol=" << tol << ")..." << std::flush;
+        start_time = hrc::now();
+
+        const uint_fast32_t N = tcsr.num_rows;
+        pprank_mat_t seeds(N, batch_size, arma::fill::zeros);
+        for (uint_fast32_t c = 0; c < batch_size; ++c) {
+            const uint_fast32_t seed = ((uint_fast64_t) N)*c/batch_size;
+            seeds(perm.empty() ? seed : perm[seed], c) = 1;
+        }
+        std::vector<uint_fast32_t> batch_iterations;
+        pprank_mat_t batch_ranks;
+        std::tie(batch_iterations, batch_ranks) = pagerank_batched(tcsr, seeds, tol);
+
+        end_time = hrc::now();
+        duration = end_time-start_time;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[" << *std::min_element(batch_iterations.begin(), batch_iterations.end()) << "-";
+        std::cout << *std::max_element(batch_iterations.begin(), batch_iterations.end()) << " iterations - ";
+        std::cout << duration.count() << " s]" << std::endl;
+
+        // compare a block product with as many matrix-vector products
+        const pprank_mat_t block(batch_size, N, arma::fill::ones);
+        const auto block_start_time = hrc::now();
+        const pprank_mat_t block_res = tcsr.tdot(block);
+        const std::chrono::duration<double> block_duration = hrc::now()-block_start_time;
+        print_tdot_times(batch_size*time_tdot(tcsr), block_duration.count());
+    }
     ////////////////////////////////////////////////////////////////////////////
 
     // write PageRanks to file
     std::cout << "[*] Writing PageRanks to file..." << std::flush;
     start_time = hrc::now();
 
-    std::ofstream outfile("PageRanks-" + std::to_string(tcsr.num_rows) + "-" + std::to_string(tcsr.a.size()) + ".txt");
+    std::ofstream outfile("PageRanks-" + std::to_string(num_nodes) + "-" + std::to_string(num_edges) + ".txt");
     outfile << std::fixed << std::scientific;
     for (uint_fast32_t node = 0; node < ranks.size(); ++node) {
         outfile << std::setfill('0') << std::setw(9) << node << ": " << ranks[node] << std::endl;
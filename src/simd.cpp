@@ -0,0 +1,184 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PPRANK_X86
+#include <immintrin.h>
+#endif
+
+#include "simd.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+const std::vector<std::string> simd_isas = {"avx512", "avx2", "scalar"};
+
+
+bool supports_isa(const std::string& isa)
+{
+    // check the features of the processor (via CPUID)
+#ifdef PPRANK_X86
+    __builtin_cpu_init();
+    if (isa == "avx512") { return __builtin_cpu_supports("avx512f"); }
+    if (isa == "avx2") { return __builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma"); }
+#endif
+    return isa == "scalar";
+}
+
+std::string detect_isa()
+{
+    // the best instruction set supported by the processor
+    for (const auto& isa : simd_isas) {
+        if (supports_isa(isa)) { return isa; }
+    }
+    return "scalar";
+}
+
+
+// each kernel computes res[j] = sum_k a[k]*vec[ja[k]] for the rows j of the transposed matrix
+// there is one overload for each precision, so that the one matching pprank_t is selected at compile time
+// (the values of the matrix are passed separately, since only the overload matching their type is called)
+
+template<typename T>
+void pull_scalar(const SimdTCSR& A, const T* a, const T* vec, T* res)
+{
+    for (uint_fast32_t j = 0; j < A.num_cols; ++j) {
+        T sum = 0;
+        for (uint_fast32_t k = A.ia[j]; k < A.ia[j+1]; ++k) {
+            sum += a[k] * vec[A.ja[k]];
+        }
+        res[j] = sum;
+    }
+}
+
+#ifdef PPRANK_X86
+// the intrinsics of some versions of GCC use undefined registers on purpose, which -Wall reports as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx2,fma")))
+void pull_avx2(const SimdTCSR& A, const float* a, const float* vec, float* res)
+{
+    const int* ja = (const int*) A.ja.data();
+    for (uint_fast32_t j = 0; j < A.num_cols; ++j) {
+        __m256 acc = _mm256_setzero_ps();
+        uint_fast32_t k = A.ia[j];
+        for (; k+8 <= A.ia[j+1]; k += 8) {
+            const __m256 x = _mm256_i32gather_ps(vec, _mm256_loadu_si256((const __m256i*) (ja+k)), 4);
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(a+k), x, acc);
+        }
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_movehdup_ps(sum4));
+        float sum = _mm_cvtss_f32(sum4);
+        for (; k < A.ia[j+1]; ++k) {
+            sum += a[k] * vec[ja[k]];
+        }
+        res[j] = sum;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void pull_avx2(const SimdTCSR& A, const double* a, const double* vec, double* res)
+{
+    const int* ja = (const int*) A.ja.data();
+    for (uint_fast32_t j = 0; j < A.num_cols; ++j) {
+        __m256d acc = _mm256_setzero_pd();
+        uint_fast32_t k = A.ia[j];
+        for (; k+4 <= A.ia[j+1]; k += 4) {
+            const __m256d x = _mm256_i32gather_pd(vec, _mm_loadu_si128((const __m128i*) (ja+k)), 8);
+            acc = _mm256_fmadd_pd(_mm256_loadu_pd(a+k), x, acc);
+        }
+        __m128d sum2 = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        sum2 = _mm_add_sd(sum2, _mm_unpackhi_pd(sum2, sum2));
+        double sum = _mm_cvtsd_f64(sum2);
+        for (; k < A.ia[j+1]; ++k) {
+            sum += a[k] * vec[ja[k]];
+        }
+        res[j] = sum;
+    }
+}
+
+__attribute__((target("avx512f")))
+void pull_avx512(const SimdTCSR& A, const float* a, const float* vec, float* res)
+{
+    // the remainder of each row is handled with masked loads and gathers
+    const int* ja = (const int*) A.ja.data();
+    for (uint_fast32_t j = 0; j < A.num_cols; ++j) {
+        __m512 acc = _mm512_setzero_ps();
+        for (uint_fast32_t k = A.ia[j]; k < A.ia[j+1]; k += 16) {
+            const uint_fast32_t left = A.ia[j+1]-k;
+            const __mmask16 mask = left >= 16 ? 0xFFFF : (1u << left)-1;
+            const __m512i idx = _mm512_maskz_loadu_epi32(mask, ja+k);
+            const __m512 x = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, idx, vec, 4);
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a+k), x, acc);
+        }
+        res[j] = _mm512_reduce_add_ps(acc);
+    }
+}
+
+__attribute__((target("avx512f")))
+void pull_avx512(const SimdTCSR& A, const double* a, const double* vec, double* res)
+{
+    // the remainder of each row is handled with masked loads and gathers
+    const int* ja = (const int*) A.ja.data();
+    for (uint_fast32_t j = 0; j < A.num_cols; ++j) {
+        __m512d acc = _mm512_setzero_pd();
+        for (uint_fast32_t k = A.ia[j]; k < A.ia[j+1]; k += 8) {
+            const uint_fast32_t left = A.ia[j+1]-k;
+            const __mmask8 mask = left >= 8 ? 0xFF : (1u << left)-1;
+            const __m256i idx = _mm512_castsi512_si256(_mm512_maskz_loadu_epi32(mask, ja+k));
+            const __m512d x = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, idx, vec, 8);
+            acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a+k), x, acc);
+        }
+        res[j] = _mm512_reduce_add_pd(acc);
+    }
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+
+SimdTCSR::SimdTCSR(const TCSR& tcsr, const std::string& isa) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), isa(isa.empty() ? detect_isa() : isa)
+{
+    // the gathers use 32-bit signed indices
+    assert(num_rows <= (uint_fast32_t) std::numeric_limits<int32_t>::max());
+    if (not supports_isa(this->isa)) {
+        std::cerr << "[!] Instruction set not supported: " << this->isa << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    TCSR transposed = tcsr.transpose();
+    a = std::move(transposed.a);
+    ia = std::move(transposed.ia);
+    ja.assign(transposed.ja.begin(), transposed.ja.end());
+
+    // the kernel is chosen once, instead of comparing the instruction set at each product
+    kernel = pull_scalar<pprank_t>;
+#ifdef PPRANK_X86
+    if (this->isa == "avx512") { kernel = pull_avx512; }
+    if (this->isa == "avx2") { kernel = pull_avx2; }
+#endif
+}
+
+pprank_vec_t SimdTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void SimdTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    kernel(*this, a.data(), vec.memptr(), res.memptr());
+}
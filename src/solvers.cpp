@@ -0,0 +1,813 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "solvers.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+template<typename R>
+QuadraticExtrapolation<R>::QuadraticExtrapolation(uint_fast32_t period, uint_fast32_t N) :
+    period(period > 0 ? std::max<uint_fast32_t>(period, 4) : 0), history(period > 0 ? 3 : 0, arma::Col<R>(N))
+{}
+
+template<typename R>
+bool QuadraticExtrapolation<R>::step(uint_fast32_t iteration, arma::Col<R>& x)
+{
+    // called with the iterate x of each iteration (numbered from one): remember it if one of the next three
+    // iterations extrapolates, or extrapolate it in place, returning whether it did
+    if (period == 0) { return false; }
+    const uint_fast32_t phase = iteration%period;
+    if (phase >= period-3) {
+        std::copy(x.memptr(), x.memptr()+x.n_elem, history[phase-(period-3)].memptr());
+        return false;
+    }
+    if (phase != 0) { return false; }
+
+    // with y_i = x_i - x_{k-3}, find the least-squares solution (g1, g2) of g1*y_{k-2} + g2*y_{k-1} = -y_k (from its
+    // normal equations, since there are only two unknowns)
+    const uint_fast32_t N = x.n_elem;
+    const R* x0 = history[0].memptr();
+    const R* x1 = history[1].memptr();
+    const R* x2 = history[2].memptr();
+    double g11 = 0, g12 = 0, g22 = 0, b1 = 0, b2 = 0;
+    for (uint_fast32_t j = 0; j < N; ++j) {
+        const double y1 = x1[j]-x0[j], y2 = x2[j]-x0[j], y3 = x[j]-x0[j];
+        g11 += y1*y1;
+        g12 += y1*y2;
+        g22 += y2*y2;
+        b1 -= y1*y3;
+        b2 -= y2*y3;
+    }
+    // the iterates have (almost) stopped changing, or change along a single direction
+    const double det = g11*g22-g12*g12;
+    if (not (det > 1e-12*g11*g22)) { return false; }
+    const double g1 = (b1*g22-b2*g12)/det, g2 = (g11*b2-g12*b1)/det;
+
+    // the extrapolated iterate, normalized since the coefficients do not add up to one
+    const double beta0 = g1+g2+1, beta1 = g2+1;
+    double sum = 0;
+    for (uint_fast32_t j = 0; j < N; ++j) {
+        x[j] = beta0*x1[j] + beta1*x2[j] + x[j];
+        sum += x[j];
+    }
+    x *= 1.0/sum;
+    ++extrapolations;
+    return true;
+}
+
+template struct QuadraticExtrapolation<float>;
+template struct QuadraticExtrapolation<double>;
+
+
+template<typename V, typename R>
+std::tuple<uint_fast32_t, arma::Col<R>> pagerank_power(const BasicTCSR<V>& A, const basic_tdot_fn<R>& tdot,
+        const double tol, const arma::Col<R>& p_init, const uint_fast32_t extrapolation_period)
+{
+    // power iteration, using tdot for the matrix-vector products with the matrix transposed, starting from p_init
+    // (if given) or from the uniform distribution, and extrapolated every extrapolation_period iterations (if not
+    // zero)
+    // all the vectors are allocated before the first iteration, and p and p_new are swapped instead of copied
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+    const R d = 0.85;
+
+    arma::Col<R> p(N), p_new(N), At_dot_p(N);
+    if (p_init.n_elem == N) { p_new = p_init; }
+    else { p_new.fill(1.0/N); }
+    QuadraticExtrapolation<R> extrapolation(extrapolation_period, N);
+
+    // ranks computation
+    uint_fast32_t iterations = 0;
+    double residual;
+    do {
+        ++iterations;
+        p.swap(p_new);
+
+        tdot(p, At_dot_p);
+
+        double dangling_sum = 0;
+        for (const auto i : A.dangling_nodes) { dangling_sum += p[i]; }
+
+        const R base = (1.0-d)/N + d*dangling_sum/N;
+        residual = 0;
+        for (uint_fast32_t j = 0; j < N; ++j) {
+            p_new[j] = base + d*At_dot_p[j];
+            residual += std::abs(p_new[j]-p[j]);
+        }
+        if (residual >= tol) { extrapolation.step(iterations, p_new); }
+    }
+    while (residual >= tol);
+    return std::make_tuple(iterations, p_new);
+}
+
+template std::tuple<uint_fast32_t, arma::Col<float>> pagerank_power(const BasicTCSR<float>&,
+        const basic_tdot_fn<float>&, const double, const arma::Col<float>&, const uint_fast32_t);
+template std::tuple<uint_fast32_t, arma::Col<double>> pagerank_power(const BasicTCSR<double>&,
+        const basic_tdot_fn<double>&, const double, const arma::Col<double>&, const uint_fast32_t);
+template std::tuple<uint_fast32_t, arma::Col<double>> pagerank_power(const BasicTCSR<float>&,
+        const basic_tdot_fn<double>&, const double, const arma::Col<double>&, const uint_fast32_t);
+template std::tuple<uint_fast32_t, arma::Col<float>> pagerank_power(const BasicTCSR<double>&,
+        const basic_tdot_fn<float>&, const double, const arma::Col<float>&, const uint_fast32_t);
+
+
+// the Krylov solvers find the PageRanks as the solution of the linear system M x = (1-d)/N, where
+// M x = x - d*(A^T x + dangling mass/N), i.e. the dangling correction is part of the operator: since the columns of
+// the Google matrix add up to one, the solution adds up to one as well, and its residual is the one of the power
+// iteration
+// their dot products and norms are accumulated in double precision, since they add up millions of tiny values
+
+template<typename R>
+inline double accurate_dot(const arma::Col<R>& x, const arma::Col<R>& y)
+{
+    double sum = 0;
+    for (uint_fast32_t j = 0; j < x.n_elem; ++j) { sum += ((double) x[j])*y[j]; }
+    return sum;
+}
+
+template<typename R>
+inline double accurate_norm1(const arma::Col<R>& x)
+{
+    double sum = 0;
+    for (uint_fast32_t j = 0; j < x.n_elem; ++j) { sum += std::abs(x[j]); }
+    return sum;
+}
+
+template<typename V, typename R>
+void apply_google(const BasicTCSR<V>& A, const basic_tdot_fn<R>& tdot, const arma::Col<R>& x, arma::Col<R>& res)
+{
+    // res = M x, with res allocated by the caller
+    const uint_fast32_t N = A.num_rows;
+    const R d = 0.85;
+    tdot(x, res);
+
+    double dangling_sum = 0;
+    for (const auto i : A.dangling_nodes) { dangling_sum += x[i]; }
+
+    const R dangling_share = d*dangling_sum/N;
+    for (uint_fast32_t j = 0; j < N; ++j) {
+        res[j] = x[j] - d*res[j] - dangling_share;
+    }
+}
+
+template<typename V, typename R>
+void google_residual(const BasicTCSR<V>& A, const basic_tdot_fn<R>& tdot, const arma::Col<R>& x, arma::Col<R>& r)
+{
+    // r = (1-d)/N - M x, with r allocated by the caller
+    const uint_fast32_t N = A.num_rows;
+    const R d = 0.85;
+    apply_google(A, tdot, x, r);
+    for (uint_fast32_t j = 0; j < N; ++j) {
+        r[j] = (1.0-d)/N - r[j];
+    }
+}
+
+
+template<typename V, typename R>
+std::tuple<uint_fast32_t, bool, arma::Col<R>> pagerank_gmres(const BasicTCSR<V>& A, const basic_tdot_fn<R>& tdot,
+        const double tol, const uint_fast32_t restart, const arma::Col<R>& p_init)
+{
+    // GMRES(restart): each cycle builds an orthonormal basis of the Krylov space of the residual (with modified
+    // Gram-Schmidt), keeping the Hessenberg matrix of M in it triangular with Givens rotations, and moves x to the
+    // point of the space minimizing the 2-norm of the residual; the cycles are restarted from the current x so that
+    // at most restart+1 vectors are stored
+    // GMRES estimates the 2-norm of the residual, so a cycle ends when the estimate, scaled by the ratio of the
+    // 1-norm to the 2-norm of the residual at its start, falls below tol, and the 1-norm is then checked exactly
+    // starts from p_init (if given) or from the uniform distribution, and returns the number of matrix-vector
+    // products, whether the residual fell below tol (it does not when tol is below what the precision of the ranks
+    // allows, and GMRES stops reducing it), and the ranks
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+    const uint_fast32_t m = std::max<uint_fast32_t>(restart, 1);
+    double last_beta = std::numeric_limits<double>::infinity();
+
+    arma::Col<R> x(N), w(N);
+    if (p_init.n_elem == N) { x = p_init; }
+    else { x.fill(1.0/N); }
+    std::vector<arma::Col<R>> Q(m+1, arma::Col<R>(N));
+    std::vector<std::vector<double>> H(m+1, std::vector<double>(m, 0));
+    std::vector<double> cs(m), sn(m), g(m+1), y(m);
+
+    // ranks computation
+    uint_fast32_t products = 0;
+    bool converged;
+    while (true) {
+        ++products;
+        google_residual(A, tdot, x, Q[0]);
+        const double beta = std::sqrt(accurate_dot(Q[0], Q[0])), residual = accurate_norm1(Q[0]);
+        converged = residual < tol or beta == 0;
+        // each cycle minimizes the 2-norm of the residual, so if a whole cycle did not reduce it, the rounding of the
+        // ranks dominates and the next cycles would not reduce it either
+        if (converged or beta >= last_beta) { break; }
+        last_beta = beta;
+        const double ratio = residual/beta;
+
+        Q[0] *= 1.0/beta;
+        std::fill(g.begin(), g.end(), 0);
+        g[0] = beta;
+
+        uint_fast32_t k = 0;
+        while (k < m) {
+            const uint_fast32_t j = k++;
+            ++products;
+            apply_google(A, tdot, Q[j], w);
+            for (uint_fast32_t i = 0; i <= j; ++i) {
+                H[i][j] = accurate_dot(w, Q[i]);
+                w -= ((R) H[i][j])*Q[i];
+            }
+            H[j+1][j] = std::sqrt(accurate_dot(w, w));
+            if (H[j+1][j] > 0) { Q[j+1] = w*(1.0/H[j+1][j]); }
+
+            // rotate the new column of the Hessenberg matrix, and then zero its subdiagonal entry
+            for (uint_fast32_t i = 0; i < j; ++i) {
+                const double h = cs[i]*H[i][j] + sn[i]*H[i+1][j];
+                H[i+1][j] = -sn[i]*H[i][j] + cs[i]*H[i+1][j];
+                H[i][j] = h;
+            }
+            const double norm = std::hypot(H[j][j], H[j+1][j]);
+            cs[j] = H[j][j]/norm;
+            sn[j] = H[j+1][j]/norm;
+            H[j][j] = norm;
+            H[j+1][j] = 0;
+            g[j+1] = -sn[j]*g[j];
+            g[j] = cs[j]*g[j];
+
+            // the basis spans an invariant subspace when the new vector vanishes, so x is then exact
+            if (std::abs(g[j+1])*ratio < tol or sn[j] == 0) { break; }
+        }
+
+        // solve the triangular system, and update x
+        for (uint_fast32_t i = k; i-- > 0;) {
+            double sum = g[i];
+            for (uint_fast32_t l = i+1; l < k; ++l) { sum -= H[i][l]*y[l]; }
+            y[i] = sum/H[i][i];
+        }
+        for (uint_fast32_t i = 0; i < k; ++i) {
+            x += ((R) y[i])*Q[i];
+        }
+    }
+    return std::make_tuple(products, converged, x);
+}
+
+
+template<typename V, typename R>
+std::tuple<uint_fast32_t, bool, arma::Col<R>> pagerank_bicgstab(const BasicTCSR<V>& A, const basic_tdot_fn<R>& tdot,
+        const double tol, const arma::Col<R>& p_init)
+{
+    // BiCGSTAB: two matrix-vector products per iteration, with short recurrences, so only a few vectors are stored
+    // the residual is updated by the recurrences, and when it falls below tol (or the iteration breaks down) it is
+    // computed again from x, restarting the iteration if it was not accurate enough
+    // starts from p_init (if given) or from the uniform distribution, and returns the number of matrix-vector
+    // products, whether the residual fell below tol (like for GMRES), and the ranks
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+
+    arma::Col<R> x(N), r(N), r_hat(N), p(N), v(N), s(N), t(N);
+    if (p_init.n_elem == N) { x = p_init; }
+    else { x.fill(1.0/N); }
+    double last_residual = std::numeric_limits<double>::infinity();
+
+    // ranks computation
+    uint_fast32_t products = 0;
+    bool converged;
+    while (true) {
+        ++products;
+        google_residual(A, tdot, x, r);
+        // like in GMRES, stop if the restarts do not reduce the residual anymore
+        const double residual = accurate_norm1(r);
+        converged = residual < tol;
+        if (converged or residual >= last_residual) { break; }
+        last_residual = residual;
+
+        r_hat = r;
+        p.zeros();
+        v.zeros();
+        double rho = 1, alpha = 1, omega = 1;
+        while (true) {
+            const double rho_new = accurate_dot(r_hat, r);
+            if (rho_new == 0) { break; }
+            const double beta = (rho_new/rho)*(alpha/omega);
+            p = r + ((R) beta)*(p - ((R) omega)*v);
+
+            ++products;
+            apply_google(A, tdot, p, v);
+            const double r_hat_v = accurate_dot(r_hat, v);
+            if (r_hat_v == 0) { break; }
+            alpha = rho_new/r_hat_v;
+            s = r - ((R) alpha)*v;
+            if (accurate_norm1(s) < tol) {
+                x += ((R) alpha)*p;
+                break;
+            }
+
+            ++products;
+            apply_google(A, tdot, s, t);
+            const double t_t = accurate_dot(t, t);
+            omega = t_t > 0 ? accurate_dot(t, s)/t_t : 0;
+            x += ((R) alpha)*p + ((R) omega)*s;
+            r = s - ((R) omega)*t;
+            if (accurate_norm1(r) < tol or omega == 0) { break; }
+            rho = rho_new;
+        }
+    }
+    return std::make_tuple(products, converged, x);
+}
+
+template std::tuple<uint_fast32_t, bool, arma::Col<float>> pagerank_gmres(const BasicTCSR<float>&,
+        const basic_tdot_fn<float>&, const double, const uint_fast32_t, const arma::Col<float>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<double>> pagerank_gmres(const BasicTCSR<double>&,
+        const basic_tdot_fn<double>&, const double, const uint_fast32_t, const arma::Col<double>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<double>> pagerank_gmres(const BasicTCSR<float>&,
+        const basic_tdot_fn<double>&, const double, const uint_fast32_t, const arma::Col<double>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<float>> pagerank_gmres(const BasicTCSR<double>&,
+        const basic_tdot_fn<float>&, const double, const uint_fast32_t, const arma::Col<float>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<float>> pagerank_bicgstab(const BasicTCSR<float>&,
+        const basic_tdot_fn<float>&, const double, const arma::Col<float>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<double>> pagerank_bicgstab(const BasicTCSR<double>&,
+        const basic_tdot_fn<double>&, const double, const arma::Col<double>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<double>> pagerank_bicgstab(const BasicTCSR<float>&,
+        const basic_tdot_fn<double>&, const double, const arma::Col<double>&);
+template std::tuple<uint_fast32_t, bool, arma::Col<float>> pagerank_bicgstab(const BasicTCSR<double>&,
+        const basic_tdot_fn<float>&, const double, const arma::Col<float>&);
+
+
+std::tuple<uint_fast32_t, pprank_vec_t> pagerank_fused(const TCSR& A, const pprank_t tol)
+{
+    // power iteration in which every iteration is a single sweep over the transposed matrix: each new rank is
+    // computed from its in-edges and immediately completed with the dangling mass, the teleport and the damping,
+    // while the residual and the dangling mass for the next iteration are accumulated along the way
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+    const pprank_t d = 0.85;
+    const TCSR At = A.transpose();
+
+    std::vector<uint8_t> dangling(N, 0);
+    for (const auto i : A.dangling_nodes) { dangling[i] = 1; }
+
+    pprank_vec_t p(N), p_new(N);
+    p_new.fill(1.0/N);
+    // the sums over all the nodes are accumulated in double precision, since they add up millions of tiny values
+    double dangling_sum = A.dangling_nodes.size()/(double) N, residual;
+
+    // ranks computation
+    uint_fast32_t iterations = 0;
+    do {
+        ++iterations;
+        p.swap(p_new);
+
+        const pprank_t base = (1.0-d)/N + d*dangling_sum/N;
+        const pprank_t* p_ptr = p.memptr();
+        pprank_t* p_new_ptr = p_new.memptr();
+        residual = 0;
+        dangling_sum = 0;
+        for (uint_fast32_t j = 0; j < N; ++j) {
+            pprank_t sum = 0;
+            for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+                sum += At.a[k] * p_ptr[At.ja[k]];
+            }
+            const pprank_t p_j = base + d*sum;
+            p_new_ptr[j] = p_j;
+            residual += std::abs(p_j-p_ptr[j]);
+            if (dangling[j]) { dangling_sum += p_j; }
+        }
+    }
+    while (residual >= tol);
+    return std::make_tuple(iterations, p_new);
+}
+
+
+std::tuple<uint_fast32_t, pprank_vec_t> pagerank_gauss_seidel(const TCSR& A, const pprank_t tol,
+        const uint_fast32_t num_threads)
+{
+    // Gauss-Seidel iteration for the linear system p = (1-d)/N + d*(A^T p + dangling mass/N): every sweep over the
+    // transposed matrix updates the ranks in place, so each rank is computed from the ranks already updated in the
+    // same sweep, and the dangling mass is kept up to date along the way
+    // with more threads, the nodes are split into blocks with about the same number of in-edges, each swept in place
+    // by a thread which reads the ranks of the other blocks (and their dangling mass) as they were at the end of the
+    // previous sweep, so that the result does not depend on the timing of the threads
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+    const pprank_t d = 0.85;
+    const TCSR At = A.transpose();
+    const std::vector<uint_fast32_t> bounds = balanced_bounds(At, std::max<uint_fast32_t>(num_threads, 1));
+    const uint_fast32_t num_blocks = bounds.size()-1;
+
+    std::vector<uint8_t> dangling(N, 0);
+    for (const auto i : A.dangling_nodes) { dangling[i] = 1; }
+
+    // the coefficient of each rank in its own equation (its self-loop, and its share of the dangling mass if it is
+    // dangling) is moved to the left-hand side
+    pprank_vec_t diagonal(N);
+    for (uint_fast32_t j = 0; j < N; ++j) {
+        double self = dangling[j] ? 1.0/N : 0.0;
+        for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+            if (At.ja[k] == j) { self += At.a[k]; }
+        }
+        diagonal[j] = 1.0-d*self;
+    }
+
+    pprank_vec_t p(N), p_old(num_blocks > 1 ? N : 0);
+    p.fill(1.0/N);
+    double dangling_sum = A.dangling_nodes.size()/(double) N, residual;
+    std::vector<double> block_residuals(num_blocks), block_dangling_sums(num_blocks), block_sums(num_blocks);
+
+    // ranks computation
+    uint_fast32_t iterations = 0;
+    do {
+        ++iterations;
+        if (num_blocks > 1) { std::copy(p.memptr(), p.memptr()+N, p_old.memptr()); }
+
+        #pragma omp parallel for schedule(static, 1) num_threads(num_blocks)
+        for (uint_fast32_t b = 0; b < num_blocks; ++b) {
+            const uint_fast32_t first = bounds[b], last = bounds[b+1];
+            pprank_t* p_ptr = p.memptr();
+            const pprank_t* p_old_ptr = num_blocks > 1 ? p_old.memptr() : p_ptr;
+
+            double block_dangling_sum = dangling_sum, block_residual = 0, block_sum = 0;
+            for (uint_fast32_t j = first; j < last; ++j) {
+                pprank_t sum = 0;
+                for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+                    const uint_fast32_t i = At.ja[k];
+                    if (i == j) { continue; }
+                    sum += At.a[k] * (first <= i and i < last ? p_ptr[i] : p_old_ptr[i]);
+                }
+                const double others_dangling_sum = block_dangling_sum-(dangling[j] ? p_ptr[j] : 0);
+                const pprank_t p_j = ((1.0-d)/N + d*(sum+others_dangling_sum/N))/diagonal[j];
+
+                block_residual += std::abs(p_j-p_ptr[j]);
+                if (dangling[j]) { block_dangling_sum += p_j-p_ptr[j]; }
+                block_sum += p_j;
+                p_ptr[j] = p_j;
+            }
+            block_residuals[b] = block_residual;
+            block_dangling_sums[b] = block_dangling_sum-dangling_sum;
+            block_sums[b] = block_sum;
+        }
+
+        residual = 0;
+        double sum = 0;
+        for (uint_fast32_t b = 0; b < num_blocks; ++b) {
+            residual += block_residuals[b];
+            dangling_sum += block_dangling_sums[b];
+            sum += block_sums[b];
+        }
+
+        // unlike the power iteration, a sweep does not preserve the sum of the ranks, whose error would then decay
+        // only by a factor d per sweep: the ranks are normalized instead
+        p *= 1.0/sum;
+        dangling_sum /= sum;
+    }
+    while (residual >= tol);
+    return std::make_tuple(iterations, p);
+}
+
+
+std::tuple<std::vector<uint_fast32_t>, pprank_mat_t> pagerank_batched(const TCSR& A, const pprank_mat_t& V,
+        const pprank_t tol)
+{
+    // personalized PageRanks for the k columns of V (a N x k matrix, each column is normalized to sum to one), all
+    // computed together with the block matrix-vector products of TCSR, which read the matrix once for all of them
+    // the teleport and the dangling nodes jump to the personalization vector instead of to a random node
+    // each column stops as soon as it converges, and it is then removed from the block
+    // returns the number of iterations of each column, and the ranks (a N x k matrix)
+    assert(A.num_rows == A.num_cols and V.n_rows == A.num_rows);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows, k = V.n_cols;
+    const pprank_t d = 0.85;
+
+    // the block stores the vectors by rows, so that the k values of a node are contiguous
+    // active[c] is the column of V in row c of the block
+    std::vector<uint_fast32_t> active(k);
+    pprank_mat_t v(k, N), p(k, N), p_new(k, N), At_dot_p(k, N);
+    for (uint_fast32_t c = 0; c < k; ++c) {
+        active[c] = c;
+        double sum = 0;
+        for (uint_fast32_t i = 0; i < N; ++i) { sum += V(i, c); }
+        for (uint_fast32_t i = 0; i < N; ++i) { v(c, i) = V(i, c)/sum; }
+    }
+    p_new.fill(1.0/N);
+
+    std::vector<uint_fast32_t> iterations(k, 0);
+    pprank_mat_t ranks(N, k);
+
+    // ranks computation
+    std::vector<double> dangling_sums, residuals;
+    for (uint_fast32_t iteration = 1; not active.empty(); ++iteration) {
+        const uint_fast32_t b = active.size();
+        p.swap(p_new);
+
+        A.tdot(p, At_dot_p);
+
+        dangling_sums.assign(b, 0);
+        for (const auto i : A.dangling_nodes) {
+            for (uint_fast32_t c = 0; c < b; ++c) { dangling_sums[c] += p(c, i); }
+        }
+
+        residuals.assign(b, 0);
+        for (uint_fast32_t j = 0; j < N; ++j) {
+            const pprank_t* v_j = v.colptr(j);
+            const pprank_t* p_j = p.colptr(j);
+            const pprank_t* At_dot_p_j = At_dot_p.colptr(j);
+            pprank_t* p_new_j = p_new.colptr(j);
+            for (uint_fast32_t c = 0; c < b; ++c) {
+                p_new_j[c] = ((1.0-d) + d*dangling_sums[c]) * v_j[c] + d*At_dot_p_j[c];
+                residuals[c] += std::abs(p_new_j[c]-p_j[c]);
+            }
+        }
+
+        // save the converged columns, and compact the others at the top of the block
+        uint_fast32_t kept = 0;
+        for (uint_fast32_t c = 0; c < b; ++c) {
+            if (residuals[c] < tol) {
+                iterations[active[c]] = iteration;
+                for (uint_fast32_t i = 0; i < N; ++i) { ranks(i, active[c]) = p_new(c, i); }
+            }
+            else {
+                active[kept++] = active[c];
+            }
+        }
+        if (kept < b) {
+            active.resize(kept);
+            pprank_mat_t v_kept(kept, N), p_new_kept(kept, N);
+            for (uint_fast32_t i = 0; i < N; ++i) {
+                for (uint_fast32_t c = 0, r = 0; c < b; ++c) {
+                    if (residuals[c] < tol) { continue; }
+                    v_kept(r, i) = v(c, i);
+                    p_new_kept(r, i) = p_new(c, i);
+                    ++r;
+                }
+            }
+            v = std::move(v_kept);
+            p_new = std::move(p_new_kept);
+            p.set_size(kept, N);
+            At_dot_p.set_size(kept, N);
+        }
+    }
+    return std::make_tuple(iterations, ranks);
+}
+
+
+std::tuple<uint_fast32_t, uint_fast32_t, uint_fast64_t, pprank_vec_t> pagerank_push_pull(const TCSR& A,
+        const pprank_t tol, const pprank_t threshold)
+{
+    // direction-optimizing PageRank: instead of the ranks, the iterations propagate the residuals (i.e. how much the
+    // ranks changed) of the active nodes, either pushing them along the out-edges of the few active nodes (CSR) or
+    // pulling them along the in-edges of all the nodes (CSC) when the active nodes have most of the edges
+    // a node is active when its residual per out-edge is above threshold times the average one, so the edges are
+    // traversed where most of the residual is, while the other residuals accumulate until they become large enough
+    // returns the number of iterations, how many of them pulled, the number of edges traversed, and the ranks
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    // without the contribution of the dangling nodes, the ranks x solve x = (1-d)/N + d * A^T x; since the dangling
+    // nodes distribute their rank uniformly like the teleport does, the PageRanks are just x normalized
+    const uint_fast32_t N = A.num_rows;
+    const pprank_t d = 0.85;
+    const TCSR At = A.transpose();
+    const double scale = threshold > 0 ? threshold : 1;
+    // the dangling nodes count as having one out-edge
+    const double weights = A.ja.size() + A.dangling_nodes.size();
+
+    pprank_vec_t x(N, arma::fill::zeros), r(N), r_active(N);
+    r.fill((1.0-d)/N);
+
+    std::vector<uint_fast32_t> frontier;
+    std::vector<pprank_t> frontier_r;
+
+    // ranks computation
+    // the residuals are never negative, so their sum is their norm; both sums are accumulated in double, since in
+    // single precision they lose the small residuals
+    uint_fast32_t iterations = 0, pulls = 0;
+    uint_fast64_t edges = 0;
+    double x_sum = 0, r_sum = 1.0-d;
+    do {
+        ++iterations;
+
+        // find the active nodes, and move their residuals into their ranks; above the average, the threshold may
+        // leave no node active, in which case it is halved (below the average, some node is always active)
+        frontier.clear();
+        frontier_r.clear();
+        uint_fast64_t frontier_edges = 0;
+        double r_left = 0;
+        for (double eps = scale*r_sum/weights; frontier.empty(); eps /= 2) {
+            r_left = 0;
+            for (uint_fast32_t i = 0; i < N; ++i) {
+                const uint_fast32_t outdegree = A.ia[i+1]-A.ia[i];
+                if (r[i] <= eps*std::max<uint_fast32_t>(outdegree, 1)) {
+                    r_left += r[i];
+                    continue;
+                }
+                frontier.push_back(i);
+                frontier_r.push_back(r[i]);
+                frontier_edges += outdegree;
+                x[i] += r[i];
+                x_sum += r[i];
+                r[i] = 0;
+            }
+        }
+
+        // like in direction-optimizing BFS, pull when the out-edges of the active nodes are most of the edges: then
+        // reading all the edges sequentially, without scattering writes, costs about as much as pushing
+        double r_added = 0;
+        if (frontier_edges > A.ja.size()/2) {
+            ++pulls;
+            edges += At.ja.size();
+            r_active.zeros();
+            for (uint_fast32_t f = 0; f < frontier.size(); ++f) {
+                r_active[frontier[f]] = frontier_r[f];
+            }
+            for (uint_fast32_t j = 0; j < N; ++j) {
+                pprank_t sum = 0;
+                for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+                    sum += At.a[k] * r_active[At.ja[k]];
+                }
+                r[j] += d * sum;
+                r_added += d * sum;
+            }
+        }
+        else {
+            edges += frontier_edges;
+            for (uint_fast32_t f = 0; f < frontier.size(); ++f) {
+                const uint_fast32_t i = frontier[f];
+                const pprank_t r_i = d * frontier_r[f];
+                for (uint_fast32_t k = A.ia[i]; k < A.ia[i+1]; ++k) {
+                    r[A.ja[k]] += A.a[k] * r_i;
+                    r_added += A.a[k] * r_i;
+                }
+            }
+        }
+
+        // the residuals left are what the normalized ranks would still change
+        r_sum = r_left + r_added;
+    }
+    while (r_sum >= tol*x_sum);
+
+    x += r;
+    double sum = 0;
+    for (uint_fast32_t i = 0; i < N; ++i) {
+        sum += x[i];
+    }
+    return std::make_tuple(iterations, pulls, edges, pprank_vec_t(x/pprank_t(sum)));
+}
+
+
+std::tuple<uint_fast32_t, uint_fast64_t, pprank_vec_t> pagerank_adaptive(const TCSR& A, const pprank_t tol,
+        const pprank_t threshold, const uint_fast32_t period)
+{
+    // adaptive PageRank (Kamvar et al., 2003): most of the ranks converge long before the others, so after a full
+    // power iteration the nodes whose rank changed by less than threshold (relative to the rank) are frozen, and the
+    // next iterations only recompute the other nodes (the in-edges from the frozen nodes are summed once, into a
+    // constant term of each row)
+    // the rows of the transposed matrix are not copied: the active nodes are listed, and the in-edges of each of
+    // them are reordered in place so that the ones from active nodes come first, and only those are traversed
+    // every period iterations, or as soon as the active nodes change less than the frozen ones did, a full iteration
+    // rechecks all the nodes, unfreezing the ones which changed again; the ranks are returned only after a full
+    // iteration within tol
+    // note that while most of the nodes are still changing, the iterations are just full power iterations, and that
+    // the frozen nodes keep drifting with the mass of the others, so the savings come from the nodes (with many
+    // in-edges) whose rank settles early, e.g. the ones linked only from pages without in-links
+    // returns the number of iterations, the number of edges traversed, and the ranks
+    assert(A.num_rows == A.num_cols);
+
+    // initialization
+    const uint_fast32_t N = A.num_rows;
+    const pprank_t d = 0.85;
+    TCSR At = A.transpose();
+    // by default, the threshold of Kamvar et al.
+    const pprank_t eps = threshold > 0 ? threshold : 1e-3;
+
+    std::vector<uint8_t> dangling(N, 0), active(N);
+    for (const auto i : A.dangling_nodes) { dangling[i] = 1; }
+
+    pprank_vec_t p(N), p_new(N);
+    p_new.fill(1.0/N);
+    double dangling_sum = A.dangling_nodes.size()/(double) N, residual;
+
+    // the active nodes: row rows[r] of the transposed matrix has its in-edges from active nodes before active_end[r]
+    std::vector<uint_fast32_t> rows, active_end;
+    std::vector<pprank_t> frozen_sums, active_p;
+    rows.reserve(N);
+    active_end.reserve(N);
+    frozen_sums.reserve(N);
+    active_p.reserve(N);
+    uint_fast64_t active_edges = 0;
+    double frozen_dangling_sum = 0, frozen_residual = 0;
+
+    // ranks computation
+    uint_fast32_t iterations = 0, since_check = 0;
+    uint_fast64_t edges = 0;
+    bool full = true;
+    while (true) {
+        ++iterations;
+        if (full) {
+            p.swap(p_new);
+
+            const pprank_t base = (1.0-d)/N + d*dangling_sum/N;
+            residual = 0;
+            dangling_sum = 0;
+            uint_fast64_t active_row_edges = 0;
+            for (uint_fast32_t j = 0; j < N; ++j) {
+                pprank_t sum = 0;
+                for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+                    sum += At.a[k] * p[At.ja[k]];
+                }
+                const pprank_t p_j = base + d*sum;
+                p_new[j] = p_j;
+                residual += std::abs(p_j-p[j]);
+                active[j] = std::abs(p_j-p[j]) > eps*p_j;
+                if (active[j]) { active_row_edges += At.ia[j+1]-At.ia[j]; }
+                if (dangling[j]) { dangling_sum += p_j; }
+            }
+            edges += At.ja.size();
+            if (residual < tol) { break; }
+
+            // reordering the rows costs about as much as an iteration over them, so it is done only when it saves
+            // enough
+            if (active_row_edges > At.ja.size()/4*3) { continue; }
+
+            // list the active nodes, moving the in-edges from active nodes to the front of their rows and summing
+            // the other ones
+            rows.clear();
+            active_end.clear();
+            frozen_sums.clear();
+            active_edges = 0;
+            frozen_dangling_sum = 0;
+            frozen_residual = 0;
+            for (uint_fast32_t j = 0; j < N; ++j) {
+                if (not active[j]) {
+                    if (dangling[j]) { frozen_dangling_sum += p_new[j]; }
+                    frozen_residual += std::abs(p_new[j]-p[j]);
+                    continue;
+                }
+                uint_fast32_t end = At.ia[j];
+                pprank_t frozen_sum = 0;
+                for (uint_fast32_t k = At.ia[j]; k < At.ia[j+1]; ++k) {
+                    if (active[At.ja[k]]) {
+                        std::swap(At.ja[k], At.ja[end]);
+                        std::swap(At.a[k], At.a[end]);
+                        ++end;
+                    }
+                    else { frozen_sum += At.a[k] * p_new[At.ja[k]]; }
+                }
+                rows.push_back(j);
+                active_end.push_back(end);
+                frozen_sums.push_back(frozen_sum);
+                active_edges += end-At.ia[j];
+            }
+            active_p.resize(rows.size());
+            since_check = 0;
+            full = false;
+        }
+        else {
+            // the new ranks of the active nodes are computed from the old ones, and written back afterwards
+            const pprank_t base = (1.0-d)/N + d*dangling_sum/N;
+            const uint_fast32_t num_active = rows.size();
+            residual = 0;
+            dangling_sum = frozen_dangling_sum;
+            for (uint_fast32_t r = 0; r < num_active; ++r) {
+                pprank_t sum = frozen_sums[r];
+                for (uint_fast32_t k = At.ia[rows[r]]; k < active_end[r]; ++k) {
+                    sum += At.a[k] * p_new[At.ja[k]];
+                }
+                active_p[r] = base + d*sum;
+                residual += std::abs(active_p[r]-p_new[rows[r]]);
+                if (dangling[rows[r]]) { dangling_sum += active_p[r]; }
+            }
+            for (uint_fast32_t r = 0; r < num_active; ++r) { p_new[rows[r]] = active_p[r]; }
+            edges += active_edges;
+
+            // the frozen nodes would still change about as much as in the last full iteration, so the full
+            // iteration cannot be within tol before the active nodes are within the rest of it, and iterating the
+            // active nodes past the change of the frozen ones only lets the two drift apart
+            if (++since_check == period or residual+frozen_residual < tol or residual < frozen_residual) {
+                full = true;
+            }
+        }
+    }
+
+    // the frozen ranks lag behind the others, so the ranks sum to 1 only up to tol
+    double sum = 0;
+    for (uint_fast32_t i = 0; i < N; ++i) {
+        sum += p_new[i];
+    }
+    return std::make_tuple(iterations, edges, pprank_vec_t(p_new/pprank_t(sum)));
+}
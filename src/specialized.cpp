@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "solvers.hpp"
+#include "specialized.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+// each kernel processes the nonzero values in groups of unroll, with a loop of fixed length which the compiler
+// unrolls, and then the ones left in the row
+// note that the differences between the indices are used in the conditions, so that they cannot overflow type I
+
+template<typename I, typename V, uint_fast32_t U>
+void push_rows(uint_fast32_t num_rows, uint_fast32_t num_cols, const I* ia, const I* ja, const V* a,
+        const pprank_t* vec, pprank_t* res)
+{
+    // res[ja[k]] += a[k]*vec[i] for the rows i of the matrix
+    std::fill(res, res+num_cols, 0);
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        const pprank_t vec_i = vec[i];
+        const I end = ia[i+1];
+        I k = ia[i];
+        for (; end-k >= U; k += U) {
+            for (uint_fast32_t u = 0; u < U; ++u) {
+                res[ja[k+u]] += a[k+u] * vec_i;
+            }
+        }
+        for (; k < end; ++k) {
+            res[ja[k]] += a[k] * vec_i;
+        }
+    }
+}
+
+template<typename I, typename V, uint_fast32_t U>
+void pull_columns(uint_fast32_t num_cols, const I* ia, const I* ja, const V* a, const pprank_t* vec, pprank_t* res)
+{
+    // res[j] = sum_k a[k]*vec[ja[k]] for the rows j of the transposed matrix, with U independent partial sums
+    for (uint_fast32_t j = 0; j < num_cols; ++j) {
+        pprank_t sums[U] = {};
+        const I end = ia[j+1];
+        I k = ia[j];
+        for (; end-k >= U; k += U) {
+            for (uint_fast32_t u = 0; u < U; ++u) {
+                sums[u] += a[k+u] * vec[ja[k+u]];
+            }
+        }
+        pprank_t sum = 0;
+        for (; k < end; ++k) {
+            sum += a[k] * vec[ja[k]];
+        }
+        for (uint_fast32_t u = 0; u < U; ++u) {
+            sum += sums[u];
+        }
+        res[j] = sum;
+    }
+}
+
+
+template<typename I, typename V, Layout L>
+constexpr uint_fast32_t SpecializedTCSR<I, V, L>::unroll;
+
+template<typename I, typename V, Layout L>
+SpecializedTCSR<I, V, L>::SpecializedTCSR(const TCSR& tcsr) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols)
+{
+    const uint64_t max_index = std::numeric_limits<I>::max();
+    assert(tcsr.a.size() <= max_index and num_rows <= max_index and num_cols <= max_index);
+
+    TCSR transposed;
+    if (L == Layout::column) { transposed = tcsr.transpose(); }
+    const TCSR& stored = L == Layout::row ? tcsr : transposed;
+    a.assign(stored.a.begin(), stored.a.end());
+    ia.assign(stored.ia.begin(), stored.ia.end());
+    ja.assign(stored.ja.begin(), stored.ja.end());
+}
+
+template<typename I, typename V, Layout L>
+pprank_vec_t SpecializedTCSR<I, V, L>::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+template<typename I, typename V, Layout L>
+void SpecializedTCSR<I, V, L>::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    // the layout is a template parameter, so only one of the kernels is compiled into each specialization
+    assert(res.n_elem == num_cols);
+    if (L == Layout::row) {
+        push_rows<I, V, unroll>(num_rows, num_cols, ia.data(), ja.data(), a.data(), vec.memptr(), res.memptr());
+    }
+    else {
+        pull_columns<I, V, unroll>(num_cols, ia.data(), ja.data(), a.data(), vec.memptr(), res.memptr());
+    }
+}
+
+
+template<typename I, typename V, Layout L>
+Specialization specialization(const std::string& name)
+{
+    // the entry of the table building the given specialization
+    return {name, 8*sizeof(I), 8*sizeof(V), [](const TCSR& tcsr) -> tdot_fn {
+        const auto specialized = std::make_shared<const SpecializedTCSR<I, V, L>>(tcsr);
+        return [specialized](const pprank_vec_t& vec, pprank_vec_t& res) { specialized->tdot(vec, res); };
+    }};
+}
+
+const std::vector<Specialization> specializations = {
+    specialization<uint32_t, float, Layout::row>("u32-float-row"),
+    specialization<uint32_t, float, Layout::column>("u32-float-column"),
+    specialization<uint32_t, double, Layout::row>("u32-double-row"),
+    specialization<uint32_t, double, Layout::column>("u32-double-column"),
+    specialization<uint64_t, float, Layout::row>("u64-float-row"),
+    specialization<uint64_t, float, Layout::column>("u64-float-column"),
+    specialization<uint64_t, double, Layout::row>("u64-double-row"),
+    specialization<uint64_t, double, Layout::column>("u64-double-column"),
+};
+
+
+bool fits(const Specialization& specialization, const TCSR& tcsr)
+{
+    // check whether the indices of the given specialization can address all the rows, columns and nonzero values
+    const uint64_t max_index = specialization.index_bits >= 64 ?
+        std::numeric_limits<uint64_t>::max() : (UINT64_C(1) << specialization.index_bits)-1;
+    return tcsr.a.size() <= max_index and tcsr.num_rows <= max_index and tcsr.num_cols <= max_index;
+}
+
+std::vector<double> calibrate_specializations(const TCSR& tcsr, uint_fast32_t repetitions)
+{
+    // the average time of a matrix-vector product of each specialization on the given matrix, or infinity for the
+    // ones which cannot represent it, or whose values do not have the precision of the ranks (which would be less
+    // accurate, or move more memory for the same accuracy)
+    std::vector<double> times;
+    for (const auto& specialization : specializations) {
+        if (not fits(specialization, tcsr) or specialization.value_bits != 8*sizeof(pprank_t)) {
+            times.push_back(std::numeric_limits<double>::infinity());
+            continue;
+        }
+        times.push_back(time_tdot_fn(specialization.build(tcsr), tcsr.num_rows, tcsr.num_cols, repetitions));
+    }
+    return times;
+}
+
+
+// the instantiations of all the combinations, also used by the table above
+template struct SpecializedTCSR<uint32_t, float, Layout::row>;
+template struct SpecializedTCSR<uint32_t, float, Layout::column>;
+template struct SpecializedTCSR<uint32_t, double, Layout::row>;
+template struct SpecializedTCSR<uint32_t, double, Layout::column>;
+template struct SpecializedTCSR<uint64_t, float, Layout::row>;
+template struct SpecializedTCSR<uint64_t, float, Layout::column>;
+template struct SpecializedTCSR<uint64_t, double, Layout::row>;
+template struct SpecializedTCSR<uint64_t, double, Layout::column>;
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "parallel.hpp"
+#include "stealing.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+using hrc = std::chrono::high_resolution_clock;
+
+
+ChunkDeque::ChunkDeque() : top(0), bottom(0)
+{
+}
+
+void ChunkDeque::reset()
+{
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(chunks.size(), std::memory_order_relaxed);
+}
+
+bool ChunkDeque::pop(uint_fast32_t& chunk)
+{
+    // take the chunk at the bottom, racing with the thieves only for the last one
+    const int_fast64_t b = bottom.load(std::memory_order_relaxed)-1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int_fast64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom.store(b+1, std::memory_order_relaxed);
+        return false;
+    }
+    chunk = chunks[b];
+    if (t < b) { return true; }
+
+    const bool won = top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom.store(b+1, std::memory_order_relaxed);
+    return won;
+}
+
+bool ChunkDeque::steal(uint_fast32_t& chunk)
+{
+    // take the chunk at the top; this fails if the deque is empty, or if another thread took the chunk first
+    int_fast64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int_fast64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) { return false; }
+    chunk = chunks[t];
+    return top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+
+StealingTCSR::StealingTCSR(const TCSR& tcsr, uint_fast32_t num_threads, uint_fast32_t chunks_per_thread) :
+    at(tcsr.transpose()), num_rows(tcsr.num_rows), num_cols(tcsr.num_cols),
+    num_threads(std::max<uint_fast32_t>(num_threads, 1)), deques(this->num_threads),
+    busy_time(this->num_threads), idle_time(this->num_threads), stolen(this->num_threads)
+{
+    // split the rows of the transposed matrix in chunks with about the same number of nonzero values, dropping the
+    // empty ones (a single row with more nonzero values than a chunk gets a chunk of its own)
+    if (chunks_per_thread == 0) { chunks_per_thread = 16; }
+    bounds = balanced_bounds(at, this->num_threads*chunks_per_thread);
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    if (bounds.size() == 1) { bounds.push_back(bounds[0]); }
+
+    // each thread starts with a contiguous range of chunks
+    const uint_fast32_t num_chunks = bounds.size()-1;
+    for (uint_fast32_t t = 0; t < this->num_threads; ++t) {
+        const uint_fast32_t first = ((uint_fast64_t) num_chunks)*t/this->num_threads;
+        const uint_fast32_t last = ((uint_fast64_t) num_chunks)*(t+1)/this->num_threads;
+        // the owner pops from the bottom, so the chunks are stored in reverse order to be computed in order
+        for (uint_fast32_t c = last; c > first; --c) { deques[t].chunks.push_back(c-1); }
+    }
+}
+
+pprank_vec_t StealingTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void StealingTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    for (auto& deque : deques) { deque.reset(); }
+
+    const auto start_time = hrc::now();
+    #pragma omp parallel num_threads(num_threads)
+    {
+#ifdef _OPENMP
+        const uint_fast32_t t = omp_get_thread_num();
+#else
+        const uint_fast32_t t = 0;
+#endif
+        // note that the runtime could provide fewer threads than requested, but the deques of the missing threads
+        // are emptied by the others anyway
+        double busy = 0;
+        uint_fast64_t steals = 0;
+        uint_fast32_t chunk;
+        while (true) {
+            bool found = deques[t].pop(chunk);
+
+            // look for a chunk in the other deques, until all of them are empty
+            for (uint_fast32_t v = (t+1) % num_threads; not found and v != t; v = (v+1) % num_threads) {
+                while (not found and deques[v].top.load() < deques[v].bottom.load()) {
+                    found = deques[v].steal(chunk);
+                    if (found) { ++steals; }
+                }
+            }
+            if (not found) { break; }
+
+            const auto chunk_start_time = hrc::now();
+            for (uint_fast32_t j = bounds[chunk]; j < bounds[chunk+1]; ++j) {
+                pprank_t sum = 0;
+                for (uint_fast32_t k = at.ia[j]; k < at.ia[j+1]; ++k) {
+                    sum += at.a[k] * vec[at.ja[k]];
+                }
+                res[j] = sum;
+            }
+            const std::chrono::duration<double> chunk_duration = hrc::now()-chunk_start_time;
+            busy += chunk_duration.count();
+        }
+        #pragma omp barrier
+
+        const std::chrono::duration<double> duration = hrc::now()-start_time;
+        busy_time[t] += busy;
+        idle_time[t] += duration.count()-busy;
+        stolen[t] += steals;
+    }
+}
+
+void StealingTCSR::reset_stats() const
+{
+    std::fill(busy_time.begin(), busy_time.end(), 0);
+    std::fill(idle_time.begin(), idle_time.end(), 0);
+    std::fill(stolen.begin(), stolen.end(), 0);
+}
@@ -1,14 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
 #include <tuple>
 #include <vector>
 
+#include <omp.h>
+
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include "autotune.hpp"
+#include "binned.hpp"
+#include "csr5.hpp"
+#include "hybrid.hpp"
+#include "mergepath.hpp"
+#include "packed.hpp"
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include "propagation.hpp"
+#include "reorder.hpp"
+#include "segmented.hpp"
+#include "simd.hpp"
+#include "solvers.hpp"
+#include "specialized.hpp"
+#include "stealing.hpp"
+#include "tiled.hpp"
 #include "utils.hpp"
 
 #include "armadillo"
 
 
+// count the dynamic allocations, to check that the iterations of the solvers do not allocate memory
+// the tests are linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=posix_memalign, so that also the
+// memory which armadillo acquires for its temporaries (with posix_memalign or malloc) is counted; operator new is
+// replaced too, since the one of the C++ runtime calls the malloc of the shared library, which is not wrapped
+std::atomic<uint_fast64_t> allocations(0);
+
+extern "C" {
+void* __real_malloc(std::size_t);
+void* __real_calloc(std::size_t, std::size_t);
+void* __real_realloc(void*, std::size_t);
+int __real_posix_memalign(void**, std::size_t, std::size_t);
+
+void* __wrap_malloc(std::size_t size)
+{
+    ++allocations;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(std::size_t count, std::size_t size)
+{
+    ++allocations;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, std::size_t size)
+{
+    ++allocations;
+    return __real_realloc(ptr, size);
+}
+
+int __wrap_posix_memalign(void** ptr, std::size_t alignment, std::size_t size)
+{
+    ++allocations;
+    return __real_posix_memalign(ptr, alignment, size);
+}
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    void* ptr = std::malloc(size ? size : 1);
+    if (not ptr) { throw std::bad_alloc(); }
+    return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+template<typename V = pprank_t>
+BasicTCSR<V> random_tcsr(uint_fast32_t num_nodes, uint_fast32_t max_outdegree, uint_fast32_t seed,
+                         uint_fast32_t num_hubs = 0)
+{
+    // build the transition matrix of a random graph, with a few dangling nodes
+    // the first num_hubs nodes are connected to about half of the graph
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint_fast32_t> outdegree(0, max_outdegree), node(0, num_nodes-1);
+
+    BasicTCSR<V> tcsr;
+    tcsr.num_rows = tcsr.num_cols = num_nodes;
+    tcsr.ia.push_back(0);
+    for (uint_fast32_t i = 0; i < num_nodes; ++i) {
+        std::vector<uint_fast32_t> row(i < num_hubs ? num_nodes/2 : outdegree(rng));
+        for (auto& j : row) { j = node(rng); }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+
+        if (row.empty()) { tcsr.dangling_nodes.push_back(i); }
+        for (const auto j : row) {
+            tcsr.a.push_back(1.0/row.size());
+            tcsr.ja.push_back(j);
+        }
+        tcsr.ia.push_back(tcsr.ja.size());
+    }
+    return tcsr;
+}
+
+TCSR frontier_tcsr(uint_fast32_t num_core, uint_fast32_t num_hubs, uint_fast32_t num_leaves, uint_fast32_t seed)
+{
+    // build the transition matrix of a graph like the frontier of a web crawl: the leaves (without in-links) link
+    // to 10-30 of the hubs each, and the hubs and the core link to 1-3 of the core nodes each
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint_fast32_t> few(1, 3), many(10, 30), core(0, num_core-1),
+                                                 hub(num_core, num_core+num_hubs-1);
+    const uint_fast32_t num_nodes = num_core+num_hubs+num_leaves;
+
+    TCSR tcsr;
+    tcsr.num_rows = tcsr.num_cols = num_nodes;
+    tcsr.ia.push_back(0);
+    for (uint_fast32_t i = 0; i < num_nodes; ++i) {
+        const bool leaf = i >= num_core+num_hubs;
+        std::vector<uint_fast32_t> row(leaf ? many(rng) : few(rng));
+        for (auto& j : row) { j = leaf ? hub(rng) : core(rng); }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+
+        for (const auto j : row) {
+            tcsr.a.push_back(1.0/row.size());
+            tcsr.ja.push_back(j);
+        }
+        tcsr.ia.push_back(tcsr.ja.size());
+    }
+    return tcsr;
+}
+
+pprank_vec_t random_vec(uint_fast32_t size, uint_fast32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<pprank_t> value(0.0, 1.0);
+
+    pprank_vec_t vec(size);
+    for (uint_fast32_t i = 0; i < size; ++i) { vec[i] = value(rng); }
+    return vec;
+}
+
+pprank_vec_t power_iteration(const TCSR& tcsr, const pprank_t tol)
+{
+    // the reference PageRanks, computed with the plain power iteration
+    const uint_fast32_t N = tcsr.num_rows;
+    const pprank_t d = 0.85;
+    const pprank_vec_t ones(N, arma::fill::ones);
+    const arma::uvec dangling_nodes = arma::conv_to<arma::uvec>::from(tcsr.dangling_nodes);
+
+    pprank_vec_t p(N), p_new(N);
+    p_new.fill(1.0/N);
+    do {
+        p = p_new;
+        pprank_vec_t At_dot_p = tcsr.tdot(p);
+        At_dot_p += arma::sum(p(dangling_nodes))/N * ones;
+        p_new = (1.0-d)/N * ones + d * At_dot_p;
+    }
+    while (arma::norm(p_new-p, 1) >= tol);
+    return p_new;
+}
+
+
 TEST_CASE( "sparse matrix construction" )
 {
     SECTION( "from graph" ) {
@@ -153,3 +320,1211 @@ TEST_CASE( "sparse matrix split" )
         }
     }
 }
+
+TEST_CASE( "sparse matrix transposition" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt").transpose();
+
+            REQUIRE(tcsr.num_rows == 3);
+            REQUIRE(tcsr.num_cols == 3);
+            REQUIRE(tcsr.a == ((const std::vector<pprank_t>) {
+                1.0, 1.0
+            }));
+            REQUIRE(tcsr.ia == ((const std::vector<uint_fast32_t>) {
+                0, 0, 1, 2
+            }));
+            REQUIRE(tcsr.ja == ((const std::vector<uint_fast32_t>) {
+                0, 1
+            }));
+        }
+    }
+}
+
+TEST_CASE( "graph reordering" )
+{
+    const TCSR tcsr = random_tcsr(500, 12, 1337);
+    const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+    const pprank_vec_t res = tcsr.tdot(vec);
+
+    for (const auto& strategy : reorder_strategies) {
+        SECTION( strategy ) {
+            const std::vector<uint_fast32_t> perm = reorder(tcsr, strategy);
+
+            std::vector<uint_fast32_t> sorted_perm(perm);
+            std::sort(sorted_perm.begin(), sorted_perm.end());
+            std::vector<uint_fast32_t> identity(tcsr.num_rows);
+            std::iota(identity.begin(), identity.end(), 0);
+            REQUIRE(sorted_perm == identity);
+
+            const TCSR reordered = tcsr.permute(perm);
+            REQUIRE(reordered.a.size() == tcsr.a.size());
+            REQUIRE(reordered.dangling_nodes.size() == tcsr.dangling_nodes.size());
+
+            pprank_vec_t permuted_vec(vec.size());
+            for (uint_fast32_t i = 0; i < perm.size(); ++i) { permuted_vec[perm[i]] = vec[i]; }
+            REQUIRE(arma::approx_equal(unpermute(reordered.tdot(permuted_vec), perm), res, "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "segmented sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const SegmentedTCSR scsr = SegmentedTCSR(TCSR("inputs/toy-3-2.txt"), 2);
+
+            REQUIRE(scsr.segments.size() == 2);
+            REQUIRE(scsr.segments[0].rows == ((const std::vector<uint_fast32_t>) {
+                0
+            }));
+            REQUIRE(scsr.segments[0].ia == ((const std::vector<uint_fast32_t>) {
+                0, 1
+            }));
+            REQUIRE(scsr.segments[0].ja == ((const std::vector<uint_fast32_t>) {
+                1
+            }));
+            REQUIRE(scsr.segments[1].rows == ((const std::vector<uint_fast32_t>) {
+                1
+            }));
+            REQUIRE(scsr.segments[1].ja == ((const std::vector<uint_fast32_t>) {
+                2
+            }));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = scsr.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(1000, 20, 7);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t segment_size : {1, 7, 64, 999, 1000, 5000}) {
+            const SegmentedTCSR scsr = SegmentedTCSR(tcsr, segment_size);
+            REQUIRE(arma::approx_equal(scsr.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "tiled sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TiledTCSR tiled = TiledTCSR(TCSR("inputs/toy-3-2.txt"), 2);
+
+            REQUIRE(tiled.tiles.size() == 2);
+            REQUIRE(tiled.tiles[0].row_base == 0);
+            REQUIRE(tiled.tiles[0].col_base == 0);
+            REQUIRE(tiled.tiles[1].row_base == 0);
+            REQUIRE(tiled.tiles[1].col_base == 2);
+            REQUIRE(tiled.rows == ((const std::vector<uint16_t>) {
+                0, 1
+            }));
+            REQUIRE(tiled.ia == ((const std::vector<uint32_t>) {
+                0, 1, 2
+            }));
+            REQUIRE(tiled.ja == ((const std::vector<uint16_t>) {
+                1, 0
+            }));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = tiled.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(100000, 6, 7);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t tile_size : {1, 7, 1000, 65536}) {
+            const TiledTCSR tiled = TiledTCSR(tcsr, tile_size);
+            REQUIRE(arma::approx_equal(tiled.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "hybrid sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 10, 7, 3);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        SECTION( "default threshold" ) {
+            const HybridTCSR hybrid = HybridTCSR(tcsr);
+
+            REQUIRE(hybrid.hubs == ((const std::vector<uint_fast32_t>) {
+                0, 1, 2
+            }));
+            REQUIRE(hybrid.regular.ia[3] == 0);
+            REQUIRE(hybrid.regular.a.size()+hybrid.hub_a.size() == tcsr.a.size());
+            REQUIRE(arma::approx_equal(hybrid.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+
+        for (const uint_fast32_t chunk_size : {1, 100, 5000}) {
+            const HybridTCSR hybrid = HybridTCSR(tcsr, 5, chunk_size);
+            REQUIRE(hybrid.hubs.size() > 3);
+            REQUIRE(arma::approx_equal(hybrid.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "bit-packed sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const PackedTCSR packed = PackedTCSR(TCSR("inputs/toy-3-2.txt"));
+
+            REQUIRE(packed.bits == 2);
+            REQUIRE(packed.packed_ja[0] == 0b1001);
+            REQUIRE(packed.col(0) == 1);
+            REQUIRE(packed.col(1) == 2);
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = packed.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        for (const uint_fast32_t num_nodes : {2, 1000, 1024, 1025, 100000}) {
+            const TCSR tcsr = random_tcsr(num_nodes, 30, 7);
+            const PackedTCSR packed = PackedTCSR(tcsr);
+
+            uint_fast32_t bits = 1;
+            while ((1u << bits) < num_nodes) { ++bits; }
+            REQUIRE(packed.bits == bits);
+
+            bool unpacked = true;
+            for (uint_fast32_t k = 0; k < tcsr.ja.size(); ++k) { unpacked = unpacked and packed.col(k) == tcsr.ja[k]; }
+            REQUIRE(unpacked);
+
+            const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+            REQUIRE(arma::approx_equal(packed.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "threaded sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const ThreadedTCSR threaded = ThreadedTCSR(tcsr, 2);
+
+            REQUIRE(threaded.bounds == ((const std::vector<uint_fast32_t>) {
+                0, 1, 3
+            }));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = threaded.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 7, 2);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t num_threads : {1, 2, 3, 8}) {
+            const ThreadedTCSR threaded = ThreadedTCSR(tcsr, num_threads);
+            REQUIRE(threaded.bounds.size() == num_threads+1);
+            REQUIRE(arma::approx_equal(threaded.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "propagation blocking sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const PropagationTCSR propagation = PropagationTCSR(tcsr, 3);
+
+            REQUIRE(propagation.bin_bits == 1);
+            REQUIRE(propagation.bin_ia == ((const std::vector<uint_fast32_t>) {
+                0, 1, 2
+            }));
+            REQUIRE(propagation.bin_ja == ((const std::vector<uint_fast32_t>) {
+                1, 2
+            }));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = propagation.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 7);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t bin_width : {1, 100, 4096, 10000}) {
+            const PropagationTCSR propagation = PropagationTCSR(tcsr, bin_width);
+            REQUIRE(arma::approx_equal(propagation.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "SIMD sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const SimdTCSR simd = SimdTCSR(TCSR("inputs/toy-3-2.txt"), "scalar");
+
+            REQUIRE(simd.ia == ((const std::vector<uint_fast32_t>) {
+                0, 0, 1, 2
+            }));
+            REQUIRE(simd.ja == ((const std::vector<uint32_t>) {
+                0, 1
+            }));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = simd.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 40, 7, 2);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        REQUIRE(supports_isa("scalar"));
+        REQUIRE(supports_isa(detect_isa()));
+        for (const auto& isa : simd_isas) {
+            if (not supports_isa(isa)) { continue; }
+            const SimdTCSR simd = SimdTCSR(tcsr, isa);
+            REQUIRE(arma::approx_equal(simd.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "prefetching sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const PrefetchTCSR prefetch = PrefetchTCSR(tcsr, 1);
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = prefetch.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 7);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        const PrefetchTCSR calibrated = PrefetchTCSR(tcsr);
+        REQUIRE(std::find(prefetch_distances.begin(), prefetch_distances.end(), calibrated.distance) !=
+                prefetch_distances.end());
+        REQUIRE(arma::approx_equal(calibrated.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+
+        for (const uint_fast32_t distance : {1, 100, 1000000}) {
+            const PrefetchTCSR prefetch = PrefetchTCSR(tcsr, distance);
+            REQUIRE(arma::approx_equal(prefetch.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+TEST_CASE( "work-stealing sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "deque" ) {
+        ChunkDeque deque;
+        deque.chunks = {2, 1, 0};
+        deque.reset();
+
+        uint_fast32_t chunk;
+        REQUIRE(deque.pop(chunk));
+        REQUIRE(chunk == 0);
+        REQUIRE(deque.steal(chunk));
+        REQUIRE(chunk == 2);
+        REQUIRE(deque.pop(chunk));
+        REQUIRE(chunk == 1);
+        REQUIRE_FALSE(deque.pop(chunk));
+        REQUIRE_FALSE(deque.steal(chunk));
+    }
+
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const StealingTCSR stealing(tcsr, 2);
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = stealing.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 7, 2);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t num_threads : {1, 2, 3, 8}) {
+            const StealingTCSR stealing(tcsr, num_threads, 4);
+            REQUIRE(stealing.bounds.front() == 0);
+            REQUIRE(stealing.bounds.back() == tcsr.num_cols);
+            REQUIRE(std::is_sorted(stealing.bounds.begin(), stealing.bounds.end()));
+
+            // every chunk must be in exactly one deque
+            std::vector<uint_fast32_t> chunks;
+            for (const auto& deque : stealing.deques) {
+                chunks.insert(chunks.end(), deque.chunks.begin(), deque.chunks.end());
+            }
+            std::sort(chunks.begin(), chunks.end());
+            std::vector<uint_fast32_t> expected(stealing.bounds.size()-1);
+            std::iota(expected.begin(), expected.end(), 0);
+            REQUIRE(chunks == expected);
+
+            for (uint_fast32_t r = 0; r < 3; ++r) {
+                REQUIRE(arma::approx_equal(stealing.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+            }
+            REQUIRE(std::accumulate(stealing.busy_time.begin(), stealing.busy_time.end(), 0.0) > 0);
+        }
+    }
+}
+
+
+TEST_CASE( "merge-path sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const MergePathTCSR mergepath(tcsr, 2);
+
+            // the transposed matrix has rows {}, {0}, {1}, so its merge path (end of row 0, value 0, end of row 1,
+            // value 1, end of row 2) is split after the first value
+            REQUIRE(mergepath.row_starts == ((const std::vector<uint_fast32_t>) {0, 1, 3}));
+            REQUIRE(mergepath.nz_starts == ((const std::vector<uint_fast32_t>) {0, 1, 2}));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = mergepath.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // the hubs of the transposed matrix have about half of the nodes as in-neighbours, so that the rows computed
+        // by the merge path are very unbalanced
+        const TCSR tcsr = random_tcsr(5000, 20, 7, 2).transpose();
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t num_threads : {1, 2, 3, 8, 64}) {
+            const MergePathTCSR mergepath(tcsr, num_threads);
+
+            // every thread gets the same number of rows and nonzero values, give or take one
+            std::vector<uint_fast64_t> work;
+            for (uint_fast32_t t = 0; t < num_threads; ++t) {
+                work.push_back(mergepath.row_starts[t+1]-mergepath.row_starts[t] +
+                               mergepath.nz_starts[t+1]-mergepath.nz_starts[t]);
+            }
+            REQUIRE(*std::max_element(work.begin(), work.end())-*std::min_element(work.begin(), work.end()) <= 1);
+            REQUIRE(mergepath.row_starts.back() == tcsr.num_cols);
+            REQUIRE(mergepath.nz_starts.back() == tcsr.a.size());
+
+            REQUIRE(arma::approx_equal(mergepath.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+
+TEST_CASE( "degree-binned sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const BinnedTCSR binned(tcsr);
+
+            // the transposed matrix has rows {}, {0}, {1}
+            REQUIRE(binned.tiny_bins[0].rows == ((const std::vector<uint_fast32_t>) {0}));
+            REQUIRE(binned.tiny_bins[1].rows == ((const std::vector<uint_fast32_t>) {1, 2}));
+            REQUIRE(binned.tiny_bins[1].ja == ((const std::vector<uint32_t>) {0, 1}));
+            REQUIRE(binned.medium_bin.rows.empty());
+            REQUIRE(binned.huge_bin.rows.empty());
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = binned.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // the rows of the hubs become rows of the transposed matrix with about half of the nodes as nonzero values,
+        // so that they are huge and span a few segments
+        const TCSR tcsr = random_tcsr(20000, 20, 7, 2).transpose();
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+
+        for (const uint_fast32_t huge_threshold : {0, 16, 1000000}) {
+            const BinnedTCSR binned(tcsr, huge_threshold);
+
+            // every row and nonzero value is in exactly one bin
+            uint_fast32_t num_rows = binned.medium_bin.rows.size()+binned.huge_bin.rows.size();
+            uint_fast64_t num_values = binned.medium_bin.a.size()+binned.huge_bin.a.size();
+            for (uint_fast32_t d = 0; d <= binned.tiny_degree; ++d) {
+                REQUIRE(binned.tiny_bins[d].a.size() == d*binned.tiny_bins[d].rows.size());
+                num_rows += binned.tiny_bins[d].rows.size();
+                num_values += binned.tiny_bins[d].a.size();
+            }
+            REQUIRE(num_rows == tcsr.num_cols);
+            REQUIRE(num_values == tcsr.a.size());
+            if (huge_threshold == 16) { REQUIRE(binned.segment_rows.size() > binned.huge_bin.rows.size()); }
+
+            REQUIRE(arma::approx_equal(binned.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+            REQUIRE(binned.bin_time[0] > 0);
+        }
+    }
+}
+
+
+TEST_CASE( "CSR5 sparse matrix-vector product with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const Csr5TCSR csr5(tcsr);
+
+            // the transposed matrix has rows {}, {0}, {1}, so its only tile starts two rows, after an empty one
+            // the two values are the first two steps of the first lane, which are stored omega values apart
+            REQUIRE(csr5.tile_ptr == ((const std::vector<uint_fast32_t>) {1}));
+            REQUIRE(csr5.bit_flag == ((const std::vector<uint64_t>) {1 | (UINT64_C(1) << csr5.omega)}));
+            REQUIRE(csr5.empty_rows == ((const std::vector<uint_fast32_t>) {0}));
+            REQUIRE(csr5.a.size() == csr5.tile_size);
+            REQUIRE(csr5.ja[0] == 0);
+            REQUIRE(csr5.ja[csr5.omega] == 1);
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            const pprank_vec_t res = csr5.tdot(vec);
+            REQUIRE(arma::approx_equal(res, (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // the rows of the transposed matrix range from empty to about half of the nodes, so that the tiles contain
+        // many short rows, or a part of a long one, or span empty rows
+        for (const bool transposed : {false, true}) {
+            const TCSR tcsr = transposed ? random_tcsr(5000, 20, 3, 2).transpose() : random_tcsr(5000, 20, 3, 2);
+            const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+            const Csr5TCSR csr5(tcsr);
+
+            // every non-empty row starts at exactly one flag
+            uint_fast64_t num_flags = 0;
+            for (const auto flags : csr5.bit_flag) { num_flags += __builtin_popcountll(flags); }
+            REQUIRE(num_flags+csr5.empty_rows.size() == tcsr.num_cols);
+            REQUIRE(csr5.tile_ptr.size() == (tcsr.a.size()+csr5.tile_size-1)/csr5.tile_size);
+
+            // within each tile, the value of lane l at step s is stored at s*omega+l
+            const TCSR at = tcsr.transpose();
+            bool transposed_tiles = true;
+            for (uint_fast64_t k = 0; k < at.ja.size(); ++k) {
+                const uint_fast32_t e = k%csr5.tile_size, l = e/csr5.sigma, s = e%csr5.sigma;
+                transposed_tiles &= csr5.ja[k-e + s*csr5.omega + l] == at.ja[k];
+            }
+            REQUIRE(transposed_tiles);
+
+            REQUIRE(arma::approx_equal(csr5.tdot(vec), tcsr.tdot(vec), "absdiff", 10e-5));
+        }
+    }
+}
+
+
+TEST_CASE( "specialized sparse matrix-vector products with the matrix transposed" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const SpecializedTCSR<uint32_t, float, Layout::column> specialized(tcsr);
+            REQUIRE(specialized.ia == ((const std::vector<uint32_t>) {0, 0, 1, 2}));
+            REQUIRE(specialized.ja == ((const std::vector<uint32_t>) {0, 1}));
+
+            pprank_vec_t vec(3);
+            vec(0) = 1337;
+            vec(1) = 0;
+            vec(2) = -42.42;
+
+            REQUIRE(arma::approx_equal(specialized.tdot(vec), (pprank_vec_t) {0, 1337, 0}, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // the hubs have many more nonzero values than the unrolling, the other rows fewer
+        const TCSR tcsr = random_tcsr(5000, 20, 11, 2);
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+        const pprank_vec_t expected = tcsr.tdot(vec);
+
+        std::vector<std::string> names;
+        for (const auto& specialization : specializations) {
+            REQUIRE(fits(specialization, tcsr));
+            pprank_vec_t res(tcsr.num_cols);
+            specialization.build(tcsr)(vec, res);
+            REQUIRE(arma::approx_equal(res, expected, "absdiff", 10e-5));
+            names.push_back(specialization.name);
+        }
+        std::sort(names.begin(), names.end());
+        REQUIRE(std::unique(names.begin(), names.end()) == names.end());
+
+        // only the specializations with values as precise as the ranks are candidates
+        const std::vector<double> times = calibrate_specializations(tcsr, 1);
+        REQUIRE(times.size() == specializations.size());
+        for (uint_fast32_t s = 0; s < specializations.size(); ++s) {
+            INFO( specializations[s].name );
+            REQUIRE(std::isinf(times[s]) == (specializations[s].value_bits != 8*sizeof(pprank_t)));
+        }
+    }
+}
+
+
+TEST_CASE( "kernel autotuning" )
+{
+    const TCSR tcsr = random_tcsr(3000, 20, 17, 2);
+
+    SECTION( "kernels" ) {
+        // every kernel built by the autotuner computes the same products
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 42);
+        const pprank_vec_t expected = tcsr.tdot(vec);
+        for (const auto& kernel : kernels) {
+            for (const uint_fast32_t num_threads : {1, 3}) {
+                pprank_vec_t res(tcsr.num_cols);
+                build_kernel(tcsr, kernel, num_threads)(vec, res);
+                REQUIRE(arma::approx_equal(res, expected, "absdiff", 10e-5));
+            }
+        }
+
+        // the kernels using the threads of OpenMP restore their number after each product
+        const int max_threads = omp_get_max_threads();
+        pprank_vec_t res(tcsr.num_cols);
+        build_kernel(tcsr, "binned", max_threads+1)(vec, res);
+        REQUIRE(omp_get_max_threads() == max_threads);
+
+        // with up to 2 threads, each of the 6 threaded kernels is also timed on 2 threads
+        const auto timings = autotune(tcsr, 2, 1);
+        REQUIRE(timings.size() == kernels.size()+6);
+        for (uint_fast32_t c = 1; c < timings.size(); ++c) {
+            REQUIRE(std::get<2>(timings[c-1]) <= std::get<2>(timings[c]));
+        }
+
+        // the specialized kernels are timed under the name of the fastest one, which can be built directly
+        for (const auto& timing : timings) {
+            INFO( std::get<0>(timing) );
+            REQUIRE(std::get<0>(timing) != "specialized");
+            pprank_vec_t res(tcsr.num_cols);
+            build_kernel(tcsr, std::get<0>(timing), std::get<1>(timing))(vec, res);
+            REQUIRE(arma::approx_equal(res, expected, "absdiff", 10e-5));
+        }
+    }
+
+    SECTION( "fingerprints" ) {
+        REQUIRE(graph_fingerprint(tcsr) == graph_fingerprint(random_tcsr(3000, 20, 17, 2)));
+        REQUIRE(graph_fingerprint(tcsr) != graph_fingerprint(random_tcsr(3000, 20, 18, 2)));
+        REQUIRE(graph_fingerprint(tcsr) != graph_fingerprint(tcsr.permute(degree_order(tcsr))));
+    }
+
+    SECTION( "cache" ) {
+        const std::string path = "tests-tuning.txt";
+        std::remove(path.c_str());
+
+        std::string kernel;
+        uint_fast32_t num_threads;
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 4);
+        REQUIRE(kernel.empty());
+
+        // the last choice for the same graph, host and threads wins, and the other ones are not affected
+        save_tuning(path, "host", "graph", 4, "simd", 1);
+        save_tuning(path, "other", "graph", 4, "tiled", 1);
+        save_tuning(path, "host", "graph", 4, "mergepath", 4);
+        save_tuning(path, "host", "graph", 2, "stealing", 2);
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 4);
+        REQUIRE(kernel == "mergepath");
+        REQUIRE(num_threads == 4);
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 2);
+        REQUIRE(kernel == "stealing");
+        REQUIRE(num_threads == 2);
+        std::tie(kernel, num_threads) = load_tuning(path, "other", "graph", 4);
+        REQUIRE(kernel == "tiled");
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "another", 4);
+        REQUIRE(kernel.empty());
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 1);
+        REQUIRE(kernel.empty());
+
+        // the specialized kernels are cached by name, and only for values of the same type as the ranks
+        const std::string value_type = sizeof(pprank_t) == sizeof(float) ? "float" : "double";
+        const std::string other_type = sizeof(pprank_t) == sizeof(float) ? "double" : "float";
+        save_tuning(path, "host", "graph", 1, "u32-" + value_type + "-column", 1);
+        save_tuning(path, "host", "graph", 1, "u16-" + value_type + "-column", 1);
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 1);
+        REQUIRE(kernel == "u32-" + value_type + "-column");
+        save_tuning(path, "host", "graph", 1, "u32-" + other_type + "-row", 1);
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 1);
+        REQUIRE(kernel == "u32-" + value_type + "-column");
+
+        // the choices made by a build with the other type of the ranks are ignored
+        const uint_fast32_t other_bits = 8*(sizeof(float)+sizeof(double)-sizeof(pprank_t));
+        std::ofstream(path, std::ios::app) << "host graph 3 " << other_bits << " csr 1" << std::endl;
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 3);
+        REQUIRE(kernel.empty());
+
+        // a cached kernel never uses more threads than allowed
+        std::ofstream(path, std::ios::app) << "host graph 3 " << 8*sizeof(pprank_t) << " csr 8" << std::endl;
+        std::tie(kernel, num_threads) = load_tuning(path, "host", "graph", 3);
+        REQUIRE(kernel.empty());
+
+        std::remove(path.c_str());
+    }
+}
+
+
+TEST_CASE( "runtime precision" )
+{
+    // the same random graph, with the nonzero values in single and double precision
+    const BasicTCSR<float> tcsr_float = random_tcsr<float>(5000, 20, 13, 2);
+    const BasicTCSR<double> tcsr_double = random_tcsr<double>(5000, 20, 13, 2);
+    REQUIRE(tcsr_float.ja == tcsr_double.ja);
+
+    SECTION( "conversion" ) {
+        // the values are computed again from the outdegrees, so they are the same as if built with the other type
+        const BasicTCSR<double> converted_double(tcsr_float);
+        REQUIRE(converted_double.ia == tcsr_double.ia);
+        REQUIRE(converted_double.ja == tcsr_double.ja);
+        REQUIRE(converted_double.a == tcsr_double.a);
+        REQUIRE(converted_double.dangling_nodes == tcsr_double.dangling_nodes);
+
+        const BasicTCSR<float> converted_float(tcsr_double);
+        REQUIRE(converted_float.a == tcsr_float.a);
+    }
+
+    SECTION( "matrix-vector product" ) {
+        const arma::vec vec = arma::conv_to<arma::vec>::from(random_vec(tcsr_float.num_rows, 42));
+        const arma::fvec vec_float = arma::conv_to<arma::fvec>::from(vec);
+
+        const arma::vec res_double = tcsr_double.tdot(vec);
+        const arma::vec res_mixed = tcsr_float.tdot(vec);
+        const arma::fvec res_float = tcsr_float.tdot(vec_float);
+        REQUIRE(arma::approx_equal(res_mixed, res_double, "absdiff", 10e-6));
+        REQUIRE(arma::approx_equal(res_float, arma::conv_to<arma::fvec>::from(res_double), "absdiff", 10e-5));
+
+        for (const uint_fast32_t num_threads : {1, 3}) {
+            const BasicThreadedTCSR<float, double> threaded_mixed(tcsr_float, num_threads);
+            const BasicThreadedTCSR<double> threaded_double(tcsr_double, num_threads);
+            REQUIRE(arma::approx_equal(threaded_mixed.tdot(vec), res_mixed, "absdiff", 10e-12));
+            REQUIRE(arma::approx_equal(threaded_double.tdot(vec), res_double, "absdiff", 10e-12));
+        }
+    }
+
+    SECTION( "PageRanks" ) {
+        const basic_tdot_fn<float> tdot_float = [&tcsr_float](const arma::fvec& vec, arma::fvec& res) {
+            tcsr_float.tdot(vec, res);
+        };
+        const basic_tdot_fn<double> tdot_mixed = [&tcsr_float](const arma::vec& vec, arma::vec& res) {
+            tcsr_float.tdot(vec, res);
+        };
+        const basic_tdot_fn<double> tdot_double = [&tcsr_double](const arma::vec& vec, arma::vec& res) {
+            tcsr_double.tdot(vec, res);
+        };
+
+        uint_fast32_t iterations;
+        arma::fvec ranks_float;
+        arma::vec ranks_mixed, ranks_double;
+        std::tie(iterations, ranks_float) = pagerank_power(tcsr_float, tdot_float, 1e-6);
+        std::tie(iterations, ranks_mixed) = pagerank_power(tcsr_float, tdot_mixed, 1e-10);
+        std::tie(iterations, ranks_double) = pagerank_power(tcsr_double, tdot_double, 1e-10);
+
+        // with double precision sums, only the rounding of the nonzero values is left
+        REQUIRE(arma::approx_equal(ranks_mixed, ranks_double, "absdiff", 10e-9));
+        REQUIRE(arma::approx_equal(ranks_float, arma::conv_to<arma::fvec>::from(ranks_double), "absdiff", 10e-7));
+
+        // the Krylov solvers accept the same precisions
+        std::tie(iterations, std::ignore, ranks_mixed) = pagerank_gmres(tcsr_float, tdot_mixed, 1e-10);
+        REQUIRE(arma::approx_equal(ranks_mixed, ranks_double, "absdiff", 10e-9));
+        std::tie(iterations, std::ignore, ranks_mixed) = pagerank_bicgstab(tcsr_float, tdot_mixed, 1e-10);
+        REQUIRE(arma::approx_equal(ranks_mixed, ranks_double, "absdiff", 10e-9));
+    }
+
+    SECTION( "escalating precision" ) {
+        const basic_tdot_fn<float> tdot_single = [&tcsr_double](const arma::fvec& vec, arma::fvec& res) {
+            tcsr_double.tdot(vec, res);
+        };
+        const basic_tdot_fn<double> tdot_double = [&tcsr_double](const arma::vec& vec, arma::vec& res) {
+            tcsr_double.tdot(vec, res);
+        };
+
+        uint_fast32_t iterations_single, iterations_escalating, iterations_double;
+        arma::fvec ranks_single;
+        arma::vec ranks_escalating, ranks_double;
+        std::tie(iterations_single, ranks_single) = pagerank_power(tcsr_double, tdot_single, escalation_tol);
+        std::tie(iterations_escalating, ranks_escalating) = pagerank_power(tcsr_double, tdot_double, 1e-10,
+                arma::conv_to<arma::vec>::from(ranks_single));
+        std::tie(iterations_double, ranks_double) = pagerank_power(tcsr_double, tdot_double, 1e-10);
+
+        // the double precision iterations start where the single precision ones stopped, and remove their rounding
+        REQUIRE(iterations_escalating < iterations_double);
+        REQUIRE(arma::approx_equal(ranks_escalating, ranks_double, "absdiff", 10e-10));
+    }
+}
+
+
+TEST_CASE( "allocation-free PageRank iterations" )
+{
+    const TCSR tcsr = random_tcsr(2000, 20, 9, 2);
+    const ThreadedTCSR threaded(tcsr, 2);
+
+    SECTION( "matrix-vector product" ) {
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 10);
+        pprank_vec_t res(tcsr.num_cols), res_threaded(tcsr.num_cols);
+
+        const uint_fast64_t before = allocations;
+        tcsr.tdot(vec, res);
+        threaded.tdot(vec, res_threaded);
+        const uint_fast64_t after = allocations;
+        REQUIRE(after == before);
+
+        REQUIRE(arma::approx_equal(res, tcsr.tdot(vec), "absdiff", 10e-7));
+        REQUIRE(arma::approx_equal(res_threaded, tcsr.tdot(vec), "absdiff", 10e-7));
+    }
+
+    SECTION( "kernels" ) {
+        // every kernel computes its products into the vector of the caller, once its storage format is built (and
+        // after a first product, which lets the runtime of OpenMP start its threads)
+        const pprank_vec_t vec = random_vec(tcsr.num_rows, 10);
+        const pprank_vec_t expected = tcsr.tdot(vec);
+        pprank_vec_t res(tcsr.num_cols);
+
+        for (const auto& kernel : kernels) {
+            INFO( kernel );
+            const tdot_fn tdot = build_kernel(tcsr, kernel, 2);
+            tdot(vec, res);
+
+            const uint_fast64_t before = allocations;
+            tdot(vec, res);
+            tdot(vec, res);
+            const uint_fast64_t after = allocations;
+            REQUIRE(after == before);
+            REQUIRE(arma::approx_equal(res, expected, "absdiff", 10e-7));
+
+            uint_fast64_t power_before = allocations;
+            const uint_fast32_t few_iterations = std::get<0>(pagerank_power(tcsr, tdot, 10));
+            const uint_fast64_t few_allocations = allocations-power_before;
+            power_before = allocations;
+            const uint_fast32_t many_iterations = std::get<0>(pagerank_power(tcsr, tdot, 1e-6));
+            const uint_fast64_t many_allocations = allocations-power_before;
+            REQUIRE(few_iterations < many_iterations);
+            REQUIRE(few_allocations == many_allocations);
+        }
+    }
+
+    SECTION( "solvers" ) {
+        // the allocations must not depend on the number of iterations
+        const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+        const tdot_fn tdot_threaded = [&threaded](const pprank_vec_t& vec, pprank_vec_t& res) {
+            threaded.tdot(vec, res);
+        };
+        const std::vector<std::function<std::tuple<uint_fast32_t, pprank_vec_t>(pprank_t)>> solvers = {
+            [&](pprank_t tol) { return pagerank_power(tcsr, tdot, tol); },
+            [&](pprank_t tol) { return pagerank_power(tcsr, tdot_threaded, tol); },
+            [&](pprank_t tol) { return pagerank_fused(tcsr, tol); },
+            [&](pprank_t tol) { return pagerank_gauss_seidel(tcsr, tol, 2); },
+        };
+        for (const auto& solver : solvers) {
+            uint_fast64_t before = allocations;
+            const uint_fast32_t few_iterations = std::get<0>(solver(10));
+            const uint_fast64_t few_allocations = allocations-before;
+
+            before = allocations;
+            const uint_fast32_t many_iterations = std::get<0>(solver(1e-6));
+            const uint_fast64_t many_allocations = allocations-before;
+
+            REQUIRE(few_iterations < many_iterations);
+            REQUIRE(few_allocations == many_allocations);
+        }
+    }
+}
+
+
+TEST_CASE( "batched personalized PageRank" )
+{
+    const TCSR tcsr = random_tcsr(2000, 20, 11, 2);
+    const uint_fast32_t N = tcsr.num_rows, k = 5;
+
+    SECTION( "block matrix-vector product" ) {
+        pprank_mat_t block(k, N);
+        std::vector<pprank_vec_t> vecs;
+        for (uint_fast32_t c = 0; c < k; ++c) {
+            vecs.push_back(random_vec(N, 12+c));
+            for (uint_fast32_t i = 0; i < N; ++i) { block(c, i) = vecs[c][i]; }
+        }
+        const pprank_mat_t res = tcsr.tdot(block);
+        REQUIRE(res.n_rows == k);
+        REQUIRE(res.n_cols == tcsr.num_cols);
+        for (uint_fast32_t c = 0; c < k; ++c) {
+            const pprank_vec_t expected = tcsr.tdot(vecs[c]);
+            pprank_vec_t res_c(N);
+            for (uint_fast32_t j = 0; j < N; ++j) { res_c[j] = res(c, j); }
+            REQUIRE(arma::approx_equal(res_c, expected, "absdiff", 10e-7));
+        }
+    }
+
+    SECTION( "personalized PageRanks" ) {
+        // the first column is uniform, so it gives the usual PageRanks; the others are single seed nodes
+        pprank_mat_t V(N, k, arma::fill::zeros);
+        for (uint_fast32_t i = 0; i < N; ++i) { V(i, 0) = 1; }
+        for (uint_fast32_t c = 1; c < k; ++c) { V(N/k*c, c) = 1; }
+
+        std::vector<uint_fast32_t> iterations;
+        pprank_mat_t ranks;
+        std::tie(iterations, ranks) = pagerank_batched(tcsr, V, 1e-6);
+        REQUIRE(iterations.size() == k);
+        REQUIRE(ranks.n_rows == N);
+        REQUIRE(ranks.n_cols == k);
+        REQUIRE(arma::approx_equal(ranks.col(0), power_iteration(tcsr, 1e-6), "absdiff", 10e-6));
+
+        // each column must be the same when computed alone
+        for (uint_fast32_t c = 1; c < k; ++c) {
+            pprank_mat_t V_c(N, 1, arma::fill::zeros);
+            V_c(N/k*c, 0) = 1;
+
+            std::vector<uint_fast32_t> iterations_c;
+            pprank_mat_t ranks_c;
+            std::tie(iterations_c, ranks_c) = pagerank_batched(tcsr, V_c, 1e-6);
+            REQUIRE(iterations_c[0] == iterations[c]);
+            REQUIRE(arma::approx_equal(ranks.col(c), ranks_c.col(0), "absdiff", 10e-7));
+            REQUIRE(ranks(N/k*c, c) > ranks(N/k*c, 0));
+        }
+    }
+}
+
+
+TEST_CASE( "fused PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+
+            uint_fast32_t iterations;
+            pprank_vec_t ranks;
+            std::tie(iterations, ranks) = pagerank_fused(tcsr, 1e-6);
+
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 8, 2);
+
+        uint_fast32_t iterations;
+        pprank_vec_t ranks;
+        std::tie(iterations, ranks) = pagerank_fused(tcsr, 1e-6);
+
+        REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-7));
+    }
+}
+
+
+TEST_CASE( "extrapolated PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            // the error of the iterates of a graph of three nodes lies in a space of two dimensions, so a single
+            // extrapolation removes it
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+
+            uint_fast32_t iterations, extrapolated_iterations;
+            pprank_vec_t ranks;
+            std::tie(iterations, ranks) = pagerank_power(tcsr, tdot, 1e-6);
+            std::tie(extrapolated_iterations, ranks) = pagerank_power(tcsr, tdot, 1e-6, pprank_vec_t(), 4);
+
+            REQUIRE(extrapolated_iterations == 5);
+            REQUIRE(extrapolated_iterations < iterations);
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 8, 2);
+        const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+
+        for (const uint_fast32_t period : {4, 5, 10}) {
+            uint_fast32_t iterations;
+            pprank_vec_t ranks;
+            std::tie(iterations, ranks) = pagerank_power(tcsr, tdot, 1e-6, pprank_vec_t(), period);
+
+            REQUIRE(std::abs(arma::sum(ranks)-1) < 10e-5);
+            REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-7));
+        }
+    }
+
+    SECTION( "history" ) {
+        // the iterates are remembered only in the three iterations before each extrapolation
+        QuadraticExtrapolation<pprank_t> extrapolation(6, 3);
+        pprank_vec_t x = {0.2, 0.3, 0.5};
+        for (uint_fast32_t iteration = 1; iteration <= 5; ++iteration) {
+            REQUIRE_FALSE(extrapolation.step(iteration, x));
+        }
+        REQUIRE(arma::approx_equal(extrapolation.history[0], x, "absdiff", 0));
+        REQUIRE(extrapolation.extrapolations == 0);
+
+        QuadraticExtrapolation<pprank_t> disabled(0, 3);
+        REQUIRE(disabled.history.empty());
+        REQUIRE_FALSE(disabled.step(4, x));
+    }
+}
+
+
+TEST_CASE( "Krylov PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+            const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+
+            // the Krylov space of a graph of three nodes has at most three dimensions
+            uint_fast32_t products;
+            bool converged;
+            pprank_vec_t ranks;
+            std::tie(products, converged, ranks) = pagerank_gmres(tcsr, tdot, 1e-6);
+
+            REQUIRE(converged);
+            REQUIRE(products <= 5);
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+
+            std::tie(products, converged, ranks) = pagerank_bicgstab(tcsr, tdot, 1e-6);
+
+            REQUIRE(converged);
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 8, 2);
+        const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+        const pprank_vec_t expected = power_iteration(tcsr, 1e-8);
+
+        for (const uint_fast32_t restart : {1, 3, 10}) {
+            uint_fast32_t products;
+            bool converged;
+            pprank_vec_t ranks;
+            std::tie(products, converged, ranks) = pagerank_gmres(tcsr, tdot, 1e-6, restart);
+
+            REQUIRE(converged);
+            REQUIRE(std::abs(arma::sum(ranks)-1) < 10e-5);
+            REQUIRE(arma::approx_equal(ranks, expected, "absdiff", 10e-7));
+        }
+
+        uint_fast32_t products;
+        bool converged;
+        pprank_vec_t ranks;
+        std::tie(products, converged, ranks) = pagerank_bicgstab(tcsr, tdot, 1e-6);
+
+        REQUIRE(converged);
+        REQUIRE(std::abs(arma::sum(ranks)-1) < 10e-5);
+        REQUIRE(arma::approx_equal(ranks, expected, "absdiff", 10e-7));
+    }
+
+    SECTION( "unreachable tol" ) {
+        // with single precision ranks, the rounding of the residual of thousands of nodes is far above tol, so the
+        // solvers stop once they cannot reduce it anymore, and report it
+        const BasicTCSR<float> tcsr = random_tcsr<float>(5000, 20, 8, 2);
+        const basic_tdot_fn<float> tdot = [&tcsr](const arma::fvec& vec, arma::fvec& res) { tcsr.tdot(vec, res); };
+
+        uint_fast32_t products;
+        bool converged;
+        arma::fvec ranks;
+        std::tie(products, converged, ranks) = pagerank_gmres(tcsr, tdot, 1e-12);
+        REQUIRE(not converged);
+        REQUIRE(std::abs(arma::sum(ranks)-1) < 10e-5);
+
+        std::tie(products, converged, ranks) = pagerank_bicgstab(tcsr, tdot, 1e-12);
+        REQUIRE(not converged);
+        REQUIRE(std::abs(arma::sum(ranks)-1) < 10e-5);
+    }
+}
+
+
+TEST_CASE( "Gauss-Seidel PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+
+            uint_fast32_t iterations;
+            pprank_vec_t ranks;
+            std::tie(iterations, ranks) = pagerank_gauss_seidel(tcsr, 1e-6);
+
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // the random graph has a few self-loops, whose coefficients are moved to the left-hand side
+        const TCSR tcsr = random_tcsr(5000, 20, 8, 2);
+        const pprank_vec_t expected = power_iteration(tcsr, 1e-8);
+
+        uint_fast32_t power_iterations;
+        pprank_vec_t ranks;
+        std::tie(power_iterations, ranks) = pagerank_fused(tcsr, 1e-6);
+
+        for (const uint_fast32_t num_threads : {1, 3}) {
+            uint_fast32_t iterations;
+            std::tie(iterations, ranks) = pagerank_gauss_seidel(tcsr, 1e-6, num_threads);
+
+            // the blocks exchange their ranks only once per sweep, so with more threads the gain shrinks
+            if (num_threads == 1) { REQUIRE(iterations < power_iterations); }
+            else { REQUIRE(iterations <= power_iterations); }
+            REQUIRE(arma::approx_equal(ranks, expected, "absdiff", 10e-7));
+        }
+    }
+}
+
+
+TEST_CASE( "direction-optimizing PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+
+            uint_fast32_t iterations, pulls;
+            uint_fast64_t edges;
+            pprank_vec_t ranks;
+            std::tie(iterations, pulls, edges, ranks) = pagerank_push_pull(tcsr, 1e-6);
+
+            REQUIRE(pulls >= 1);
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        const TCSR tcsr = random_tcsr(5000, 20, 7, 2);
+
+        uint_fast32_t iterations, pulls;
+        uint_fast64_t edges;
+        pprank_vec_t ranks;
+        std::tie(iterations, pulls, edges, ranks) = pagerank_push_pull(tcsr, 1e-6);
+
+        REQUIRE(pulls < iterations);
+        REQUIRE(edges < iterations*tcsr.a.size());
+        REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-5));
+    }
+
+    SECTION( "sparse random graph" ) {
+        // without hubs and with few out-edges per node the ranks converge slowly, and most of the residual is on a
+        // few nodes at a time: the iterations push it from them, and traverse fewer edges than the plain power
+        // iteration needs for the same tol
+        const TCSR tcsr = random_tcsr(5000, 3, 9);
+        const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+        const uint_fast32_t power_iterations = std::get<0>(pagerank_power(tcsr, tdot, 1e-6));
+
+        uint_fast32_t iterations, pulls;
+        uint_fast64_t edges;
+        pprank_vec_t ranks;
+        std::tie(iterations, pulls, edges, ranks) = pagerank_push_pull(tcsr, 1e-6);
+
+        INFO( "power iterations: " << power_iterations << ", pulls: " << pulls << "/" << iterations );
+        REQUIRE(pulls < iterations);
+        REQUIRE(edges < power_iterations*tcsr.a.size());
+        REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-5));
+        REQUIRE(std::accumulate(ranks.begin(), ranks.end(), 0.0) == Approx(1.0).epsilon(1e-5));
+    }
+}
+
+
+TEST_CASE( "adaptive PageRank" )
+{
+    SECTION( "from graph" ) {
+        SECTION( "toy.txt" ) {
+            const TCSR tcsr = TCSR("inputs/toy-3-2.txt");
+
+            uint_fast32_t iterations;
+            uint_fast64_t edges;
+            pprank_vec_t ranks;
+            std::tie(iterations, edges, ranks) = pagerank_adaptive(tcsr, 1e-6);
+
+            REQUIRE(arma::approx_equal(ranks, (pprank_vec_t) {1.844169e-01, 3.411710e-01, 4.744120e-01}, "absdiff",
+                                       10e-5));
+        }
+    }
+
+    SECTION( "random graph" ) {
+        // with a large threshold, most of the nodes are frozen in the last iterations
+        const TCSR tcsr = random_tcsr(5000, 20, 7, 2);
+
+        uint_fast32_t iterations;
+        uint_fast64_t edges;
+        pprank_vec_t ranks;
+        std::tie(iterations, edges, ranks) = pagerank_adaptive(tcsr, 1e-6, 1e-2);
+
+        REQUIRE(edges < iterations*tcsr.a.size());
+        REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-5));
+        REQUIRE(std::accumulate(ranks.begin(), ranks.end(), 0.0) == Approx(1.0).epsilon(1e-5));
+    }
+
+    SECTION( "crawl frontier graph" ) {
+        // most of the edges point to the hubs, whose ranks settle after two iterations while those of the core
+        // still change; with the default threshold, the iterations skipping the hubs traverse fewer edges than the
+        // plain power iteration needs for the same tol
+        const TCSR tcsr = frontier_tcsr(1000, 200, 3800, 1);
+        const tdot_fn tdot = [&tcsr](const pprank_vec_t& vec, pprank_vec_t& res) { tcsr.tdot(vec, res); };
+        const uint_fast32_t power_iterations = std::get<0>(pagerank_power(tcsr, tdot, 1e-6));
+
+        uint_fast32_t iterations;
+        uint_fast64_t edges;
+        pprank_vec_t ranks;
+        std::tie(iterations, edges, ranks) = pagerank_adaptive(tcsr, 1e-6);
+
+        INFO( "power iterations: " << power_iterations << ", adaptive iterations: " << iterations );
+        REQUIRE(edges < power_iterations*tcsr.a.size());
+        REQUIRE(arma::approx_equal(ranks, power_iteration(tcsr, 1e-6), "absdiff", 10e-5));
+        REQUIRE(std::accumulate(ranks.begin(), ranks.end(), 0.0) == Approx(1.0).epsilon(1e-5));
+    }
+}
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "segmented.hpp"
+#include "tiled.hpp"
+#include "utils.hpp"
+
+#include "armadillo"
+
+
+uint_fast32_t default_tile_size()
+{
+    // the largest tile addressable with 16-bit indices, unless a smaller one is needed to keep its writes in cache
+    return std::min<uint_fast32_t>(default_segment_size(), 65536);
+}
+
+
+TiledTCSR::TiledTCSR(const TCSR& tcsr, uint_fast32_t tile_size) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), tile_size(tile_size > 0 ? tile_size : default_tile_size())
+{
+    // split a matrix into tiles, ordered by columns first
+    assert(this->tile_size <= 65536);
+    assert(tcsr.a.size() <= std::numeric_limits<uint32_t>::max());
+
+    // the column segments already contain the non-empty rows of each column of tiles in order
+    const SegmentedTCSR scsr(tcsr, this->tile_size);
+
+    a.reserve(tcsr.a.size());
+    ja.reserve(tcsr.ja.size());
+    ia.push_back(0);
+    for (uint_fast32_t s = 0; s < scsr.segments.size(); ++s) {
+        const SegmentedTCSR::Segment& segment = scsr.segments[s];
+        const uint_fast32_t col_base = s*this->tile_size;
+
+        for (uint_fast32_t r = 0; r < segment.rows.size();) {
+            Tile tile;
+            tile.row_base = segment.rows[r]/this->tile_size*this->tile_size;
+            tile.col_base = col_base;
+            tile.first_row = rows.size();
+
+            for (; r < segment.rows.size() and segment.rows[r] < tile.row_base+this->tile_size; ++r) {
+                rows.push_back(segment.rows[r]-tile.row_base);
+                for (uint_fast32_t k = segment.ia[r]; k < segment.ia[r+1]; ++k) {
+                    a.push_back(segment.a[k]);
+                    ja.push_back(segment.ja[k]-col_base);
+                }
+                ia.push_back(ja.size());
+            }
+
+            tile.last_row = rows.size();
+            tiles.push_back(tile);
+        }
+    }
+    assert(a.size() == tcsr.a.size() and ja.size() == tcsr.ja.size());
+}
+
+pprank_vec_t TiledTCSR::tdot(const pprank_vec_t& vec) const
+{
+    // compute a matrix-vector product with the matrix transposed
+    pprank_vec_t res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+void TiledTCSR::tdot(const pprank_vec_t& vec, pprank_vec_t& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller, one tile at a time
+    assert(res.n_elem == num_cols);
+    res.zeros();
+    for (const Tile& tile : tiles) {
+        const pprank_t* vec_tile = vec.memptr()+tile.row_base;
+        pprank_t* res_tile = res.memptr()+tile.col_base;
+        for (uint_fast32_t r = tile.first_row; r < tile.last_row; ++r) {
+            const pprank_t vec_i = vec_tile[rows[r]];
+            for (uint_fast32_t k = ia[r]; k < ia[r+1]; ++k) {
+                res_tile[ja[k]] += a[k] * vec_i;
+            }
+        }
+    }
+}
+
+uint_fast64_t TiledTCSR::index_bytes() const
+{
+    // the size of all the indices needed to locate the nonzero values
+    return tiles.size()*sizeof(Tile) + rows.size()*sizeof(uint16_t) + ia.size()*sizeof(uint32_t) +
+           ja.size()*sizeof(uint16_t);
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -6,9 +7,15 @@
 #include <regex>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <string.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#endif
 
 #include "utils.hpp"
 
@@ -24,11 +31,16 @@ inline void read_edge(char* line, uint_fast32_t& from_node, uint_fast32_t& to_no
 }
 
 
-TCSR::TCSR()
+const std::vector<std::string> precisions = {"float", "double", "mixed", "escalating"};
+
+
+template<typename V>
+BasicTCSR<V>::BasicTCSR()
 {
 }
 
-TCSR::TCSR(const std::string& filename)
+template<typename V>
+BasicTCSR<V>::BasicTCSR(const std::string& filename)
 {
     // construct a transition (sparse) matrix from a file
     // each line of the file represents an edge from a source node to a destination node
@@ -122,34 +134,95 @@ TCSR::TCSR(const std::string& filename)
     file.close();
 }
 
-pprank_vec_t TCSR::tdot(const pprank_vec_t& vec) const
+template<typename V>
+template<typename U>
+BasicTCSR<V>::BasicTCSR(const BasicTCSR<U>& tcsr) :
+    num_rows(tcsr.num_rows), num_cols(tcsr.num_cols), ia(tcsr.ia), ja(tcsr.ja), dangling_nodes(tcsr.dangling_nodes)
+{
+    // construct the same transition matrix with values of another type
+    // the values only depend on the outdegrees of the nodes, so they are computed again instead of converted
+    // (widening a value already rounded to single precision would not give the double precision value)
+    a.reserve(tcsr.a.size());
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        const uint_fast32_t outdegree = ia[i+1]-ia[i];
+        for (uint_fast32_t k = ia[i]; k < ia[i+1]; ++k) {
+            a.push_back(1.0/outdegree);
+        }
+    }
+}
+
+template<typename V>
+template<typename R>
+arma::Col<R> BasicTCSR<V>::tdot(const arma::Col<R>& vec) const
 {
     // compute a matrix-vector product with the matrix transposed
-    pprank_vec_t res(num_cols, arma::fill::zeros);
+    arma::Col<R> res(num_cols);
+    tdot(vec, res);
+    return res;
+}
+
+template<typename V>
+template<typename R>
+void BasicTCSR<V>::tdot(const arma::Col<R>& vec, arma::Col<R>& res) const
+{
+    // same as above, but into a vector of num_cols elements allocated by the caller
+    assert(res.n_elem == num_cols);
+    std::fill(res.memptr(), res.memptr()+num_cols, 0);
     for (uint_fast32_t i = 0; i < num_rows; ++i) {
         for (uint_fast32_t k = ia[i]; k < ia[i+1]; ++k) {
             res[ja[k]] += a[k] * vec[i];
         }
     }
+}
+
+template<typename V>
+template<typename R>
+arma::Mat<R> BasicTCSR<V>::tdot(const arma::Mat<R>& block) const
+{
+    // compute the matrix-vector products of the matrix transposed with a block of k vectors at once
+    // the block is stored by rows, i.e. it is a k x num_rows matrix whose column i holds the k values of node i, so
+    // that each nonzero value is loaded only once for all the vectors
+    arma::Mat<R> res(block.n_rows, num_cols);
+    tdot(block, res);
     return res;
 }
 
-std::tuple<std::vector<uint_fast32_t>, std::vector<uint_fast32_t>, std::vector<TCSR>> TCSR::split(uint_fast32_t n) const
+template<typename V>
+template<typename R>
+void BasicTCSR<V>::tdot(const arma::Mat<R>& block, arma::Mat<R>& res) const
+{
+    // same as above, but into a k x num_cols matrix allocated by the caller
+    assert(block.n_cols == num_rows and res.n_rows == block.n_rows and res.n_cols == num_cols);
+    const uint_fast32_t k = block.n_rows;
+    std::fill(res.memptr(), res.memptr()+res.n_elem, 0);
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        const R* block_i = block.colptr(i);
+        for (uint_fast32_t e = ia[i]; e < ia[i+1]; ++e) {
+            const R a_e = a[e];
+            R* res_j = res.colptr(ja[e]);
+            for (uint_fast32_t c = 0; c < k; ++c) { res_j[c] += a_e * block_i[c]; }
+        }
+    }
+}
+
+template<typename V>
+std::tuple<std::vector<uint_fast32_t>, std::vector<uint_fast32_t>, std::vector<BasicTCSR<V>>> BasicTCSR<V>::split(
+    uint_fast32_t n) const
 {
     // split the matrix by rows into n submatrices
     assert(0 < n and n <= num_rows);
 
     std::vector<uint_fast32_t> displacements, sizes;
-    std::vector<TCSR> tcsrs;
+    std::vector<BasicTCSR> tcsrs;
 
     // compute maximum size of each submatrix
     // note that the last one can have fewer rows than the others
-    const uint_fast32_t max_size = std::ceil(((pprank_t) num_rows)/n);
+    const uint_fast32_t max_size = std::ceil(((double) num_rows)/n);
 
     uint_fast32_t i = 1, j = 0;
     uint_fast32_t start = 0, offset = 0;
     do {
-        TCSR tcsr;
+        BasicTCSR tcsr;
 
         tcsr.ia.push_back(0);
 
@@ -180,3 +253,118 @@ std::tuple<std::vector<uint_fast32_t>, std::vector<uint_fast32_t>, std::vector<T
     assert(displacements.size() == sizes.size() and sizes.size() == tcsrs.size());
     return std::make_tuple(displacements, sizes, tcsrs);
 }
+
+template<typename V>
+BasicTCSR<V> BasicTCSR<V>::permute(const std::vector<uint_fast32_t>& perm) const
+{
+    // relabel the nodes of the graph, i.e. node i becomes node perm[i]
+    // row i is moved to row perm[i] and its column indices are renamed accordingly
+    assert(num_rows == num_cols and perm.size() == num_rows);
+
+    BasicTCSR tcsr;
+    tcsr.num_rows = num_rows;
+    tcsr.num_cols = num_cols;
+
+    // compute the inverse permutation, i.e. which old row ends up in each new row
+    std::vector<uint_fast32_t> inv_perm(num_rows);
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        inv_perm[perm[i]] = i;
+    }
+
+    tcsr.a.reserve(a.size());
+    tcsr.ja.reserve(ja.size());
+    tcsr.ia.reserve(ia.size());
+    tcsr.ia.push_back(0);
+
+    std::vector<std::pair<uint_fast32_t, V>> row;
+    for (uint_fast32_t new_i = 0; new_i < num_rows; ++new_i) {
+        const uint_fast32_t i = inv_perm[new_i];
+        if (ia[i] == ia[i+1]) { tcsr.dangling_nodes.push_back(new_i); }
+
+        row.clear();
+        for (uint_fast32_t k = ia[i]; k < ia[i+1]; ++k) {
+            row.emplace_back(perm[ja[k]], a[k]);
+        }
+        // keep the column indices of each row sorted, so that consecutive writes are as close as possible
+        std::sort(row.begin(), row.end());
+        for (const auto& entry : row) {
+            tcsr.ja.push_back(entry.first);
+            tcsr.a.push_back(entry.second);
+        }
+        tcsr.ia.push_back(tcsr.ja.size());
+    }
+
+    assert(tcsr.a.size() == a.size() and tcsr.ja.size() == ja.size());
+    return tcsr;
+}
+
+template<typename V>
+BasicTCSR<V> BasicTCSR<V>::transpose() const
+{
+    // construct the transposed matrix (equivalently, the CSC representation of this matrix)
+    // note that dangling nodes are not computed, since they are meaningful only for the transition matrix
+    BasicTCSR tcsr;
+    tcsr.num_rows = num_cols;
+    tcsr.num_cols = num_rows;
+
+    // count the nonzero values of each column
+    tcsr.ia.assign(num_cols+1, 0);
+    for (uint_fast32_t k = 0; k < ja.size(); ++k) {
+        ++tcsr.ia[ja[k]+1];
+    }
+    for (uint_fast32_t j = 0; j < num_cols; ++j) {
+        tcsr.ia[j+1] += tcsr.ia[j];
+    }
+
+    // scatter the nonzero values, visiting the rows in order so that the new column indices come out sorted
+    tcsr.a.resize(a.size());
+    tcsr.ja.resize(ja.size());
+    std::vector<uint_fast32_t> next(tcsr.ia.begin(), tcsr.ia.end()-1);
+    for (uint_fast32_t i = 0; i < num_rows; ++i) {
+        for (uint_fast32_t k = ia[i]; k < ia[i+1]; ++k) {
+            const uint_fast32_t dst = next[ja[k]]++;
+            tcsr.ja[dst] = i;
+            tcsr.a[dst] = a[k];
+        }
+    }
+    return tcsr;
+}
+
+// the instantiations for the runtime precisions
+template struct BasicTCSR<float>;
+template struct BasicTCSR<double>;
+template BasicTCSR<float>::BasicTCSR(const BasicTCSR<double>&);
+template BasicTCSR<double>::BasicTCSR(const BasicTCSR<float>&);
+template arma::Col<float> BasicTCSR<float>::tdot(const arma::Col<float>&) const;
+template arma::Col<double> BasicTCSR<float>::tdot(const arma::Col<double>&) const;
+template arma::Col<double> BasicTCSR<double>::tdot(const arma::Col<double>&) const;
+template arma::Col<float> BasicTCSR<double>::tdot(const arma::Col<float>&) const;
+template void BasicTCSR<float>::tdot(const arma::Col<float>&, arma::Col<float>&) const;
+template void BasicTCSR<float>::tdot(const arma::Col<double>&, arma::Col<double>&) const;
+template void BasicTCSR<double>::tdot(const arma::Col<double>&, arma::Col<double>&) const;
+template void BasicTCSR<double>::tdot(const arma::Col<float>&, arma::Col<float>&) const;
+template arma::Mat<float> BasicTCSR<float>::tdot(const arma::Mat<float>&) const;
+template arma::Mat<double> BasicTCSR<double>::tdot(const arma::Mat<double>&) const;
+template void BasicTCSR<float>::tdot(const arma::Mat<float>&, arma::Mat<float>&) const;
+template void BasicTCSR<double>::tdot(const arma::Mat<double>&, arma::Mat<double>&) const;
+
+
+uint_fast32_t cache_size()
+{
+    // return the size (in bytes) of the per-core L2 cache, falling back to the last level cache if not available
+    // note that the default of 256 KB is assumed if the size cannot be detected
+    long size = 0;
+#ifdef __APPLE__
+    int64_t sysctl_size = 0;
+    size_t len = sizeof(sysctl_size);
+    if (sysctlbyname("hw.l2cachesize", &sysctl_size, &len, nullptr, 0) == 0) { size = sysctl_size; }
+#else
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    if (size <= 0) { size = sysconf(_SC_LEVEL3_CACHE_SIZE); }
+#endif
+#endif
+    return size > 0 ? size : 256*1024;
+}